@@ -1,2 +1,35 @@
 #define SERIAL_BAUD_RATE 115200
-#define DEFLAULT_DEVICE_ADDRESS 0x08
\ No newline at end of file
+#define DEFLAULT_DEVICE_ADDRESS 0x08
+
+// Parent status cache and web responses, shared with the fleet simulator
+#ifndef SWEEP_INTERVAL
+#define SWEEP_INTERVAL 2000 // How often the device status cache is refreshed
+#endif
+#ifndef JSON_BUFFER_SIZE
+#define JSON_BUFFER_SIZE 1536 // Fits /api/status for MAX_DEVICES devices
+#endif
+
+// Binary telemetry export (see lib/Telemetry), override with build_flags
+#ifndef TELEMETRY_HOST
+#define TELEMETRY_HOST "255.255.255.255" // Collector address, broadcast by default
+#endif
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT 4210
+#endif
+#ifndef TELEMETRY_LOCAL_PORT
+#define TELEMETRY_LOCAL_PORT 4211 // Sending socket; must differ so broadcasts to TELEMETRY_PORT don't queue on it
+#endif
+#ifndef TELEMETRY_INTERVAL
+#define TELEMETRY_INTERVAL 10000 // Milliseconds between exports, 0 disables
+#endif
+
+// Long-term data log on the SD card (see lib/DataLog)
+#ifndef DATALOG_SD_CS_PIN
+#define DATALOG_SD_CS_PIN 4 // MKR SD Proto shield
+#endif
+#ifndef DATALOG_FILE
+#define DATALOG_FILE "DATALOG.BIN"
+#endif
+#ifndef DATALOG_INTERVAL
+#define DATALOG_INTERVAL 60000 // Milliseconds between logged readings; valve changes are logged at once
+#endif
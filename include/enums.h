@@ -15,7 +15,17 @@ enum DeviceAction
   DEVICE_ACTIVATE,
   DEVICE_DEACTIVATE,
   DEVICE_IDENTIFY,
-  DEVICE_SLEEP
+  DEVICE_SLEEP,
+  DEVICE_BULK_STATUS,
+  DEVICE_DIAGNOSTICS
+};
+
+enum CommandResult
+{
+  COMMAND_NONE,
+  COMMAND_OK,
+  COMMAND_UNKNOWN,
+  COMMAND_MALFORMED
 };
 
 #endif
\ No newline at end of file
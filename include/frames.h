@@ -0,0 +1,60 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <stdint.h>
+
+// Bulk status frame returned by a child after DEVICE_BULK_STATUS.
+// Shared by the SAMD parent and AVR child, both little-endian, so the
+// struct is sent over the wire as-is.
+struct __attribute__((packed)) DeviceStatusFrame
+{
+  uint8_t status;            // DeviceStatus
+  uint16_t moisture;         // Raw analog reading (0-1023)
+  uint8_t valveOpen;         // 1 while the valve is energised
+  uint32_t uptimeSeconds;    // Seconds since the child booted
+  uint32_t flowPulses;       // Flow sensor pulses since boot
+  uint8_t lastCommandResult; // CommandResult of the last command received
+  uint16_t errorCount;       // Malformed or unknown commands since boot
+  uint8_t checksum;          // Two's complement of the sum of all previous bytes
+};
+
+// Memory report returned by a child after DEVICE_DIAGNOSTICS, see lib/Diagnostics
+struct __attribute__((packed)) DeviceMemoryFrame
+{
+  uint16_t ramSize;
+  uint16_t staticSize;     // .data + .bss
+  uint16_t heapSize;       // Current heap extent
+  uint16_t heapHighWater;  // Largest heap extent sampled since boot
+  uint16_t stackHighWater; // Deepest stack use since boot, from stack painting
+  uint16_t freeNow;        // Gap between heap and stack pointer right now
+  uint16_t freeMin;        // Smallest gap between heap and stack since boot
+  uint8_t checksum;
+};
+
+// Sum of all bytes before the checksum field, which every frame has last
+template <typename Frame>
+uint8_t frameSum(const Frame &frame)
+{
+  const uint8_t *bytes = (const uint8_t *)&frame;
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < sizeof(Frame) - 1; i++)
+  {
+    sum += bytes[i];
+  }
+  return sum;
+}
+
+template <typename Frame>
+void sealFrame(Frame &frame)
+{
+  frame.checksum = (uint8_t)(0 - frameSum(frame));
+}
+
+// Rejects short reads, which the master pads with 0xFF
+template <typename Frame>
+bool isFrameValid(const Frame &frame)
+{
+  return (uint8_t)(frameSum(frame) + frame.checksum) == 0;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "DataLog.h"
+#include <string.h>
+
+DataLog::DataLog(LogStorage &storage)
+    : storage(storage), pendingCount(0), blockCount(0), lastTimestamp(0), indexStride(1), blocksRead(0), droppedRecords(0)
+{
+}
+
+// Bitwise CRC-32 (IEEE), no table so it costs no RAM on the boards
+uint32_t DataLog::crc32(const uint8_t *data, size_t length, uint32_t crc)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+uint32_t DataLog::blockCrc(const uint8_t *block)
+{
+  uint32_t crc = crc32(block, offsetof(LogBlockHeader, crc), 0);
+  return crc32(block + sizeof(LogBlockHeader), DATALOG_BLOCK_SIZE - sizeof(LogBlockHeader), crc);
+}
+
+bool DataLog::readHeader(uint32_t block, LogBlockHeader &header)
+{
+  return storage.read(block * DATALOG_BLOCK_SIZE, (uint8_t *)&header, sizeof(header)) &&
+         header.magic == DATALOG_MAGIC && header.sequence == block;
+}
+
+LogBlockState DataLog::loadBlock(uint32_t block)
+{
+  blocksRead++;
+  if (!storage.read(block * DATALOG_BLOCK_SIZE, readBlock, DATALOG_BLOCK_SIZE))
+    return LOG_BLOCK_UNREADABLE;
+
+  const LogBlockHeader *header = (const LogBlockHeader *)readBlock;
+  bool valid = header->magic == DATALOG_MAGIC && header->sequence == block &&
+               header->recordCount <= DATALOG_RECORDS_PER_BLOCK && header->crc == blockCrc(readBlock);
+  return valid ? LOG_BLOCK_VALID : LOG_BLOCK_CORRUPT;
+}
+
+void DataLog::indexBlock(uint32_t block, uint32_t firstTimestamp)
+{
+  if (block % indexStride != 0)
+    return;
+
+  while (block / indexStride >= DATALOG_INDEX_SIZE)
+  {
+    // Out of entries: keep every other one and halve the resolution
+    for (uint32_t i = 0; i < DATALOG_INDEX_SIZE / 2; i++)
+      index[i] = index[2 * i];
+    indexStride *= 2;
+
+    if (block % indexStride != 0)
+      return;
+  }
+
+  index[block / indexStride] = firstTimestamp;
+}
+
+bool DataLog::mount()
+{
+  pendingCount = 0;
+  blocksRead = 0;
+  lastTimestamp = 0;
+  blockCount = storage.size() / DATALOG_BLOCK_SIZE;
+
+  // Only the last append can be torn by a power cut; it is overwritten by the next one
+  if (blockCount > 0)
+  {
+    LogBlockState state = loadBlock(blockCount - 1);
+    if (state == LOG_BLOCK_CORRUPT)
+    {
+      blockCount--;
+      state = blockCount > 0 ? loadBlock(blockCount - 1) : LOG_BLOCK_VALID;
+    }
+    if (state != LOG_BLOCK_VALID)
+      return false;
+  }
+
+  if (blockCount > 0)
+  {
+    const LogBlockHeader *header = (const LogBlockHeader *)readBlock;
+    const LogRecord *records = (const LogRecord *)(readBlock + sizeof(LogBlockHeader));
+    lastTimestamp = header->recordCount > 0 ? records[header->recordCount - 1].timestamp : header->firstTimestamp;
+  }
+
+  indexStride = 1;
+  while ((blockCount + indexStride - 1) / indexStride > DATALOG_INDEX_SIZE)
+    indexStride *= 2;
+
+  uint32_t entries = (blockCount + indexStride - 1) / indexStride;
+  uint32_t previous = 0;
+  for (uint32_t i = 0; i < entries; i++)
+  {
+    LogBlockHeader header;
+    // A damaged block inherits its predecessor's time so the index stays sorted
+    index[i] = readHeader(i * indexStride, header) ? header.firstTimestamp : previous;
+    previous = index[i];
+  }
+
+  return true;
+}
+
+LogAppendResult DataLog::append(LogRecord record)
+{
+  // A full block whose write failed is retried first; if storage is still
+  // failing the record is dropped rather than written past writeBlock
+  if (pendingCount == DATALOG_RECORDS_PER_BLOCK && !flush())
+  {
+    droppedRecords++;
+    return LOG_DROPPED;
+  }
+
+  // Binary search over the log needs non-decreasing time, e.g. across an RTC correction
+  if (record.timestamp < lastTimestamp)
+    record.timestamp = lastTimestamp;
+  lastTimestamp = record.timestamp;
+
+  LogRecord *records = (LogRecord *)(writeBlock + sizeof(LogBlockHeader));
+  records[pendingCount++] = record;
+
+  // On a failed write the full block is kept and retried by the next append
+  if (pendingCount == DATALOG_RECORDS_PER_BLOCK && !flush())
+    return LOG_WRITE_FAILED;
+  return LOG_APPENDED;
+}
+
+bool DataLog::flush()
+{
+  if (pendingCount == 0)
+    return true;
+
+  const LogRecord *records = (const LogRecord *)(writeBlock + sizeof(LogBlockHeader));
+  LogBlockHeader *header = (LogBlockHeader *)writeBlock;
+  header->magic = DATALOG_MAGIC;
+  header->recordCount = pendingCount;
+  header->reserved = 0;
+  header->sequence = blockCount;
+  header->firstTimestamp = records[0].timestamp;
+
+  size_t used = sizeof(LogBlockHeader) + pendingCount * sizeof(LogRecord);
+  memset(writeBlock + used, 0, DATALOG_BLOCK_SIZE - used);
+  header->crc = blockCrc(writeBlock);
+
+  if (!storage.write(blockCount * DATALOG_BLOCK_SIZE, writeBlock, DATALOG_BLOCK_SIZE) || !storage.flush())
+    return false;
+
+  indexBlock(blockCount, header->firstTimestamp);
+  blockCount++;
+  pendingCount = 0;
+  return true;
+}
+
+bool DataLog::sync(uint32_t now)
+{
+  if (pendingCount == 0)
+    return true;
+
+  const LogRecord *records = (const LogRecord *)(writeBlock + sizeof(LogBlockHeader));
+  if (pendingCount < DATALOG_RECORDS_PER_BLOCK && now - records[0].timestamp < DATALOG_MAX_PENDING_AGE)
+    return true;
+
+  return flush();
+}
+
+// Last block starting strictly before from, so records equal to from that
+// spill over from the previous block are not missed
+uint32_t DataLog::findStartBlock(uint32_t from)
+{
+  uint32_t entries = (blockCount + indexStride - 1) / indexStride;
+  uint32_t entry = 0;
+  while (entry + 1 < entries && index[entry + 1] < from)
+    entry++;
+
+  // Narrow down between two index entries by reading block headers only
+  uint32_t low = entry * indexStride;
+  uint32_t high = low + indexStride;
+  if (high > blockCount)
+    high = blockCount;
+
+  while (high - low > 1)
+  {
+    uint32_t middle = low + (high - low) / 2;
+    LogBlockHeader header;
+    blocksRead++;
+    if (readHeader(middle, header) && header.firstTimestamp >= from)
+      high = middle;
+    else
+      low = middle;
+  }
+
+  return low;
+}
+
+bool DataLog::visitRecords(const uint8_t *block, uint8_t count, uint32_t from, uint32_t to,
+                           LogVisitor visitor, void *context, uint32_t &visited)
+{
+  const LogRecord *records = (const LogRecord *)(block + sizeof(LogBlockHeader));
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (records[i].timestamp > to)
+      return false;
+
+    if (records[i].timestamp >= from)
+    {
+      if (!visitor(records[i], context))
+        return false;
+      visited++;
+    }
+  }
+  return true;
+}
+
+uint32_t DataLog::query(uint32_t from, uint32_t to, LogVisitor visitor, void *context)
+{
+  uint32_t visited = 0;
+  if (from > to)
+    return 0;
+
+  for (uint32_t block = blockCount > 0 ? findStartBlock(from) : 0; block < blockCount; block++)
+  {
+    // Corrupt blocks are skipped; failing storage ends the query
+    LogBlockState state = loadBlock(block);
+    if (state == LOG_BLOCK_UNREADABLE)
+      return visited;
+    if (state == LOG_BLOCK_CORRUPT)
+      continue;
+
+    const LogBlockHeader *header = (const LogBlockHeader *)readBlock;
+    if (!visitRecords(readBlock, header->recordCount, from, to, visitor, context, visited))
+      return visited;
+  }
+
+  visitRecords(writeBlock, pendingCount, from, to, visitor, context, visited);
+  return visited;
+}
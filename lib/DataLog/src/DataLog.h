@@ -0,0 +1,129 @@
+#ifndef DATA_LOG_H
+#define DATA_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DATALOG_BLOCK_SIZE 512 // One SD sector per append
+#define DATALOG_MAGIC 0x4C44   // "DL"
+#define DATALOG_INDEX_SIZE 128 // Sparse index entries kept in RAM
+#ifndef DATALOG_MAX_PENDING_AGE
+#define DATALOG_MAX_PENDING_AGE 900 // Seconds before a partial block is written anyway
+#endif
+
+enum LogRecordType
+{
+  LOG_READING = 1,
+  LOG_VALVE_EVENT = 2
+};
+
+struct __attribute__((packed)) LogRecord
+{
+  uint32_t timestamp; // Unix seconds, never decreasing within the log
+  uint8_t type;       // LogRecordType
+  uint8_t address;
+  uint8_t valveOpen;
+  uint8_t status; // DeviceStatus
+  uint16_t moisture;
+  uint16_t errorCount;
+  uint32_t flowPulses;
+};
+
+// Every block starts with this header; crc covers the rest of the block
+struct __attribute__((packed)) LogBlockHeader
+{
+  uint16_t magic;
+  uint8_t recordCount;
+  uint8_t reserved;
+  uint32_t sequence; // Block number, guards against stale data
+  uint32_t firstTimestamp;
+  uint32_t crc;
+};
+
+#define DATALOG_RECORDS_PER_BLOCK ((DATALOG_BLOCK_SIZE - sizeof(LogBlockHeader)) / sizeof(LogRecord))
+
+// Byte-addressed backing store: an SD card file on the parent, a plain file natively
+class LogStorage
+{
+public:
+  virtual uint32_t size() = 0;
+  virtual bool read(uint32_t offset, uint8_t *buffer, size_t length) = 0;
+  virtual bool write(uint32_t offset, const uint8_t *buffer, size_t length) = 0;
+  virtual bool flush() = 0;
+};
+
+// Outcome of reading one block from storage
+enum LogBlockState
+{
+  LOG_BLOCK_VALID,
+  LOG_BLOCK_CORRUPT,   // Read back but fails the header or CRC checks, e.g. torn by a power cut
+  LOG_BLOCK_UNREADABLE // The storage read itself failed
+};
+
+// Outcome of appending one record
+enum LogAppendResult
+{
+  LOG_APPENDED,     // Stored, and any full block was written
+  LOG_WRITE_FAILED, // Stored in RAM, but the full block could not be written yet
+  LOG_DROPPED       // Not stored: the block is full and storage is still failing
+};
+
+// Returns false to end the query, e.g. when the client has gone away
+typedef bool (*LogVisitor)(const LogRecord &record, void *context);
+
+// Log-structured record store. Records are batched in RAM and written as
+// whole CRC-protected blocks at the end of the storage; a sparse in-RAM
+// index of block start times lets range queries seek directly.
+class DataLog
+{
+private:
+  LogStorage &storage;
+  uint8_t writeBlock[DATALOG_BLOCK_SIZE];
+  uint8_t readBlock[DATALOG_BLOCK_SIZE];
+  uint8_t pendingCount;
+  uint32_t blockCount;
+  uint32_t lastTimestamp;
+  uint32_t index[DATALOG_INDEX_SIZE];
+  uint32_t indexStride; // Blocks between index entries, doubles as the log grows
+  uint32_t blocksRead;
+  uint32_t droppedRecords;
+
+  static uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc);
+  static uint32_t blockCrc(const uint8_t *block);
+  bool readHeader(uint32_t block, LogBlockHeader &header);
+  LogBlockState loadBlock(uint32_t block);
+  void indexBlock(uint32_t block, uint32_t firstTimestamp);
+  uint32_t findStartBlock(uint32_t from);
+  bool visitRecords(const uint8_t *block, uint8_t count, uint32_t from, uint32_t to,
+                    LogVisitor visitor, void *context, uint32_t &visited);
+
+public:
+  DataLog(LogStorage &storage);
+  // Recovers the log end and rebuilds the index; drops a torn last block.
+  // False if storage cannot be read or more than the last block is damaged,
+  // since appending would then overwrite history.
+  bool mount();
+  // A full block that failed to write is kept and retried by later appends
+  // and syncs; records arriving while it stays full are dropped and counted
+  LogAppendResult append(LogRecord record);
+  // Writes the pending records even if the block is not full
+  bool flush();
+  // Flushes once the oldest pending record is older than DATALOG_MAX_PENDING_AGE,
+  // or at once if a full block is waiting to be retried
+  bool sync(uint32_t now);
+  // Calls visitor for every record with from <= timestamp <= to, oldest first,
+  // holding one block in RAM at a time, until the visitor returns false.
+  // Returns the number of records the visitor accepted.
+  uint32_t query(uint32_t from, uint32_t to, LogVisitor visitor, void *context);
+
+  uint32_t getBlockCount() const { return blockCount; }
+  // Timestamp of the newest record, 0 for an empty log
+  uint32_t getLastTimestamp() const { return lastTimestamp; }
+  uint8_t getPendingCount() const { return pendingCount; }
+  // Blocks read from storage since mount, for checking query cost
+  uint32_t getBlocksRead() const { return blocksRead; }
+  // Records dropped by append() while storage was failing
+  uint32_t getDroppedRecords() const { return droppedRecords; }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SD_LOG_STORAGE_H
+#define SD_LOG_STORAGE_H
+
+#include <SD.h>
+#include "DataLog.h"
+
+// LogStorage backed by a single file on the SD card
+class SdLogStorage : public LogStorage
+{
+private:
+  File file;
+
+public:
+  bool begin(uint8_t csPin, const char *path)
+  {
+    if (!SD.begin(csPin))
+      return false;
+
+    // No O_APPEND: a torn last block has to be overwritten in place
+    file = SD.open(path, O_READ | O_WRITE | O_CREAT);
+    return (bool)file;
+  }
+
+  uint32_t size()
+  {
+    return file ? file.size() : 0;
+  }
+
+  bool read(uint32_t offset, uint8_t *buffer, size_t length)
+  {
+    return file && file.seek(offset) && file.read(buffer, length) == (int)length;
+  }
+
+  bool write(uint32_t offset, const uint8_t *buffer, size_t length)
+  {
+    return file && file.seek(offset) && file.write(buffer, length) == length;
+  }
+
+  bool flush()
+  {
+    if (!file)
+      return false;
+    file.flush();
+    return true;
+  }
+};
+
+#endif
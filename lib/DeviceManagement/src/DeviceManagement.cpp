@@ -4,8 +4,6 @@
 #include "enums.h"
 
 #define DEFAULT_ADDRESS 0x00       // Default address for unassigned devices
-#define BASE_ASSIGNED_ADDRESS 0x08 // Starting address for assignment
-#define MAX_DEVICES 10             // Maximum number of devices to track
 #define MAX_I2C_BUFFER 32          // Maximum I2C buffer size
 
 uint8_t maxI2cBuffer = MAX_I2C_BUFFER;
@@ -13,6 +11,13 @@ uint8_t nextAvailableAddress = BASE_ASSIGNED_ADDRESS;
 uint8_t knownDevices[MAX_DEVICES];
 uint8_t deviceCount = 0;
 
+// Sweep results, reused on every sweep
+DeviceStatusFrame statusFrames[MAX_DEVICES];
+bool statusValid[MAX_DEVICES];
+// True while the child's current action is DEVICE_BULK_STATUS, so a sweep
+// can skip the selector write and read the frame in a single transaction
+bool statusSelected[MAX_DEVICES];
+
 void DeviceManagement::setup()
 {
   // Initialize Wire library
@@ -58,8 +63,8 @@ void DeviceManagement::discoverDevices()
 
   for (address = 1; address < 127; address++)
   {
-    // Skip address 0x60 (ATECC508A CryptoAuthentication chip)
-    if (address == 0x60)
+    // Skip the ATECC508A CryptoAuthentication chip
+    if (address == CRYPTO_CHIP_ADDRESS)
       continue;
 
     // Skip default unassigned address
@@ -155,6 +160,10 @@ void DeviceManagement::sendDeviceCommand(uint8_t address, DeviceAction action)
   Wire.beginTransmission(address);
   Wire.write(action);
   Wire.endTransmission();
+
+  int8_t index = findDevice(address);
+  if (index >= 0)
+    statusSelected[index] = false;
 }
 
 String DeviceManagement::getDeviceData(uint8_t address)
@@ -164,6 +173,10 @@ String DeviceManagement::getDeviceData(uint8_t address)
     Serial.print("0");
   Serial.println(address, HEX);
 
+  int8_t index = findDevice(address);
+  if (index >= 0)
+    statusSelected[index] = false;
+
   Wire.beginTransmission(address);
   Wire.write(DEVICE_STATUS);
   byte error = Wire.endTransmission();
@@ -203,4 +216,80 @@ String DeviceManagement::getDeviceData(uint8_t address)
   }
 
   return String("");
+}
+
+int8_t DeviceManagement::findDevice(uint8_t address)
+{
+  for (uint8_t i = 0; i < deviceCount; i++)
+  {
+    if (knownDevices[i] == address)
+      return i;
+  }
+
+  return -1;
+}
+
+// Selects action unless the child is already on it, then reads a fixed-size frame
+bool DeviceManagement::readFrame(uint8_t address, DeviceAction action, bool selected, uint8_t *bytes, uint8_t size)
+{
+  if (!selected)
+  {
+    Wire.beginTransmission(address);
+    Wire.write(action);
+    if (Wire.endTransmission() != 0)
+      return false;
+  }
+
+  // The child answers from cached values, so no settle delay is needed
+  uint8_t received = Wire.requestFrom(address, size);
+  uint8_t count = 0;
+  while (Wire.available() && count < size)
+  {
+    bytes[count++] = Wire.read();
+  }
+
+  return received == size && count == size;
+}
+
+bool DeviceManagement::readStatusFrame(uint8_t address, bool selected, DeviceStatusFrame &frame)
+{
+  return readFrame(address, DEVICE_BULK_STATUS, selected, (uint8_t *)&frame, sizeof(frame)) && isFrameValid(frame);
+}
+
+// Re-reads one device into the sweep cache, e.g. right after a command
+bool DeviceManagement::refreshDevice(uint8_t address)
+{
+  int8_t index = findDevice(address);
+  if (index < 0)
+    return false;
+
+  statusValid[index] = readStatusFrame(address, statusSelected[index], statusFrames[index]);
+  statusSelected[index] = statusValid[index];
+  return statusValid[index];
+}
+
+bool DeviceManagement::getDeviceMemory(uint8_t address, DeviceMemoryFrame &frame)
+{
+  // Moves the child off DEVICE_BULK_STATUS, so the next sweep reselects it
+  int8_t index = findDevice(address);
+  if (index >= 0)
+    statusSelected[index] = false;
+
+  return readFrame(address, DEVICE_DIAGNOSTICS, false, (uint8_t *)&frame, sizeof(frame)) && isFrameValid(frame);
+}
+
+DeviceSweep DeviceManagement::sweepDevices()
+{
+  for (uint8_t i = 0; i < deviceCount; i++)
+  {
+    statusValid[i] = readStatusFrame(knownDevices[i], statusSelected[i], statusFrames[i]);
+    statusSelected[i] = statusValid[i];
+  }
+
+  return getLastSweep();
+}
+
+DeviceSweep DeviceManagement::getLastSweep()
+{
+  return {knownDevices, statusFrames, statusValid, deviceCount};
 }
\ No newline at end of file
@@ -3,6 +3,14 @@
 
 #include <Arduino.h>
 #include "enums.h"
+#include "frames.h"
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 10 // Maximum number of devices to track
+#endif
+
+#define BASE_ASSIGNED_ADDRESS 0x08 // Starting address for assignment
+#define CRYPTO_CHIP_ADDRESS 0x60   // ATECC508A on the MKR1000, skipped by discoverDevices()
 
 struct DeviceBuffer
 {
@@ -10,10 +18,23 @@ struct DeviceBuffer
   size_t size;
 };
 
+// View over the preallocated sweep buffers; valid[i] is false when the
+// frame for addresses[i] could not be read on the last sweep.
+struct DeviceSweep
+{
+  const uint8_t *addresses;
+  const DeviceStatusFrame *frames;
+  const bool *valid;
+  size_t size;
+};
+
 class DeviceManagement
 {
 private:
   void assignAddress(byte defaultAddr);
+  int8_t findDevice(uint8_t address);
+  bool readFrame(uint8_t address, DeviceAction action, bool selected, uint8_t *bytes, uint8_t size);
+  bool readStatusFrame(uint8_t address, bool selected, DeviceStatusFrame &frame);
 
 public:
   void setup();
@@ -21,6 +42,10 @@ public:
   DeviceBuffer getConnectedDevices();
   void sendDeviceCommand(uint8_t address, DeviceAction action);
   String getDeviceData(uint8_t address);
+  bool refreshDevice(uint8_t address);
+  bool getDeviceMemory(uint8_t address, DeviceMemoryFrame &frame);
+  DeviceSweep sweepDevices();
+  DeviceSweep getLastSweep();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#include "StatusJson.h"
+
+void buildStatusJson(JsonDocument &doc, const DeviceSweep &devices, float temperature, float humidity)
+{
+  doc["temperature"] = temperature;
+  doc["humidity"] = humidity;
+
+  JsonArray list = doc["devices"].to<JsonArray>();
+  for (uint8_t i = 0; i < devices.size; i++)
+  {
+    JsonObject device = list.add<JsonObject>();
+    device["address"] = devices.addresses[i];
+    device["valid"] = devices.valid[i];
+    if (!devices.valid[i])
+      continue;
+
+    const DeviceStatusFrame &frame = devices.frames[i];
+    device["moisture"] = frame.moisture;
+    device["valveOpen"] = (bool)frame.valveOpen;
+    device["uptime"] = frame.uptimeSeconds;
+    device["flowPulses"] = frame.flowPulses;
+    device["lastCommand"] = frame.lastCommandResult;
+    device["errors"] = frame.errorCount;
+  }
+}
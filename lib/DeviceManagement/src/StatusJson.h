@@ -0,0 +1,10 @@
+#ifndef STATUS_JSON_H
+#define STATUS_JSON_H
+
+#include <ArduinoJson.h>
+#include "DeviceManagement.h"
+
+// Document served as /api/status; the fleet simulator measures the same one
+void buildStatusJson(JsonDocument &doc, const DeviceSweep &devices, float temperature, float humidity);
+
+#endif
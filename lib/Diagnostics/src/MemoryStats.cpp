@@ -0,0 +1,122 @@
+#include "MemoryStats.h"
+#include <stddef.h>
+
+#if defined(__AVR__)
+#include <avr/io.h>
+
+// Symbols from the avr-libc linker script and malloc
+extern char __data_start;
+extern char __bss_end;
+extern char __heap_start;
+extern char *__brkval;
+
+static char *ramStart() { return &__data_start; }
+static char *staticEnd() { return &__bss_end; }
+static char *heapStart() { return &__heap_start; }
+static char *heapEnd() { return __brkval ? __brkval : &__heap_start; }
+static char *stackTop() { return (char *)RAMEND + 1; }
+static char *stackPointer() { return (char *)SP; }
+
+#define HAS_MEMORY_LAYOUT
+
+#elif defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+
+// Symbols from the SAMD core linker script; newlib's sbrk moves the heap end
+extern "C" char *sbrk(int increment);
+extern char __data_start__;
+extern char __bss_end__;
+extern char end;
+extern char __StackTop;
+
+static char *ramStart() { return &__data_start__; }
+static char *staticEnd() { return &__bss_end__; }
+static char *heapStart() { return &end; }
+static char *heapEnd() { return sbrk(0); }
+static char *stackTop() { return &__StackTop; }
+static char *stackPointer() { return (char *)__get_MSP(); }
+
+#define HAS_MEMORY_LAYOUT
+
+#endif
+
+static MemoryStats stats;
+
+#ifdef HAS_MEMORY_LAYOUT
+
+static char *paintBottom = NULL;
+static char *heapPeak = NULL;
+static char *stackLow = NULL; // Lowest address the stack is known to have touched
+
+// Kept out of line so its own frame sits above the painted region
+__attribute__((noinline)) void paintStack()
+{
+  char *bottom = heapEnd();
+  char *top = stackPointer() - STACK_PAINT_MARGIN;
+
+  for (char *p = bottom; p < top; p++)
+  {
+    *p = (char)STACK_PAINT;
+  }
+
+  paintBottom = bottom;
+  heapPeak = bottom;
+  stackLow = top;
+  sampleMemory();
+}
+
+void sampleMemory()
+{
+  char *heap = heapEnd();
+  if (heap > heapPeak)
+    heapPeak = heap;
+
+  // Heap growth also overwrites paint, so only scan above the heap peak.
+  // The stack only ever deepens, so the scan stops at the last low-water mark.
+  char *scan = heapPeak > paintBottom ? heapPeak : paintBottom;
+  while (scan < stackLow && *scan == (char)STACK_PAINT)
+  {
+    scan++;
+  }
+  if (scan < stackLow)
+    stackLow = scan;
+
+  char *sp = stackPointer();
+  stats.ramSize = stackTop() - ramStart();
+  stats.staticSize = staticEnd() - ramStart();
+  stats.heapSize = heap - heapStart();
+  stats.heapHighWater = heapPeak - heapStart();
+  stats.stackHighWater = stackTop() - stackLow;
+  stats.freeNow = sp > heap ? sp - heap : 0;
+  stats.freeMin = stackLow > heapPeak ? stackLow - heapPeak : 0;
+}
+
+#else
+
+// Host builds have no fixed RAM layout to inspect; stats stay zero
+void paintStack() {}
+void sampleMemory() {}
+
+#endif
+
+const MemoryStats &getMemoryStats()
+{
+  return stats;
+}
+
+static uint16_t clampSize(uint32_t size)
+{
+  return size > UINT16_MAX ? UINT16_MAX : (uint16_t)size;
+}
+
+void fillMemoryFrame(DeviceMemoryFrame &frame)
+{
+  frame.ramSize = clampSize(stats.ramSize);
+  frame.staticSize = clampSize(stats.staticSize);
+  frame.heapSize = clampSize(stats.heapSize);
+  frame.heapHighWater = clampSize(stats.heapHighWater);
+  frame.stackHighWater = clampSize(stats.stackHighWater);
+  frame.freeNow = clampSize(stats.freeNow);
+  frame.freeMin = clampSize(stats.freeMin);
+  sealFrame(frame);
+}
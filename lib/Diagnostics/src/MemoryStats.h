@@ -0,0 +1,32 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <stdint.h>
+#include "frames.h"
+
+#define MEMORY_SAMPLE_INTERVAL 1000 // Stack scans touch all free RAM, keep them off the hot path
+#define STACK_PAINT 0xA5
+#define STACK_PAINT_MARGIN 32 // Bytes below the stack pointer left alone while painting
+
+// All sizes in bytes. The heap high-water mark is sampled, so a short-lived
+// allocation between two samples can be missed; the stack high-water mark is
+// exact up to a used byte that happens to equal STACK_PAINT.
+struct MemoryStats
+{
+  uint32_t ramSize;
+  uint32_t staticSize;
+  uint32_t heapSize;
+  uint32_t heapHighWater;
+  uint32_t stackHighWater;
+  uint32_t freeNow;
+  uint32_t freeMin;
+};
+
+// Fills the gap between heap and stack with STACK_PAINT. Call first thing in setup().
+void paintStack();
+// Updates the high-water marks; call every MEMORY_SAMPLE_INTERVAL from loop()
+void sampleMemory();
+const MemoryStats &getMemoryStats();
+void fillMemoryFrame(DeviceMemoryFrame &frame);
+
+#endif
@@ -0,0 +1,225 @@
+#include "HttpRequest.h"
+#include <string.h>
+
+static char toLower(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  c = toLower(c);
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+static StringView trim(const char *begin, const char *end)
+{
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    end--;
+  return {begin, (size_t)(end - begin)};
+}
+
+bool StringView::equals(const char *text) const
+{
+  return strlen(text) == length && memcmp(data, text, length) == 0;
+}
+
+bool StringView::equalsIgnoreCase(const char *text) const
+{
+  if (strlen(text) != length)
+    return false;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    if (toLower(data[i]) != toLower(text[i]))
+      return false;
+  }
+  return true;
+}
+
+bool StringView::containsIgnoreCase(const char *text) const
+{
+  size_t textLength = strlen(text);
+  for (size_t start = 0; start + textLength <= length; start++)
+  {
+    StringView candidate = {data + start, textLength};
+    if (candidate.equalsIgnoreCase(text))
+      return true;
+  }
+  return false;
+}
+
+HttpRequestBuffer::HttpRequestBuffer()
+{
+  reset();
+}
+
+void HttpRequestBuffer::reset()
+{
+  length = 0;
+  lineEnds = 0;
+  complete = false;
+  truncated = false;
+}
+
+size_t HttpRequestBuffer::append(const char *bytes, size_t count)
+{
+  for (size_t i = 0; i < count && !complete; i++)
+  {
+    char c = bytes[i];
+    if (length < HTTP_BUFFER_SIZE)
+      data[length++] = c;
+    else
+      truncated = true;
+
+    if (c == '\n')
+    {
+      if (++lineEnds == 2)
+      {
+        complete = true;
+        return i + 1;
+      }
+    }
+    else if (c != '\r')
+    {
+      lineEnds = 0;
+    }
+  }
+
+  return count;
+}
+
+bool parseRequest(const char *data, size_t length, HttpRequest &request)
+{
+  const char *end = data + length;
+  const char *lineEnd = (const char *)memchr(data, '\n', length);
+  if (lineEnd == NULL)
+    return false;
+
+  const char *methodEnd = (const char *)memchr(data, ' ', lineEnd - data);
+  if (methodEnd == NULL || methodEnd == data)
+    return false;
+
+  const char *target = methodEnd + 1;
+  const char *targetEnd = (const char *)memchr(target, ' ', lineEnd - target);
+  if (targetEnd == NULL || target == targetEnd || *target != '/')
+    return false;
+
+  const char *queryStart = (const char *)memchr(target, '?', targetEnd - target);
+
+  request.method = {data, (size_t)(methodEnd - data)};
+  if (queryStart != NULL)
+  {
+    request.path = {target, (size_t)(queryStart - target)};
+    request.query = {queryStart + 1, (size_t)(targetEnd - queryStart - 1)};
+  }
+  else
+  {
+    request.path = {target, (size_t)(targetEnd - target)};
+    request.query = {targetEnd, 0};
+  }
+  request.headers = {lineEnd + 1, (size_t)(end - lineEnd - 1)};
+  return true;
+}
+
+bool findHeader(const HttpRequest &request, const char *name, StringView &value)
+{
+  const char *line = request.headers.data;
+  const char *end = line + request.headers.length;
+
+  // Only newline-terminated lines, so a truncated last line is ignored
+  const char *lineEnd;
+  while (line < end && (lineEnd = (const char *)memchr(line, '\n', end - line)) != NULL)
+  {
+    const char *colon = (const char *)memchr(line, ':', lineEnd - line);
+    if (colon != NULL)
+    {
+      StringView key = {line, (size_t)(colon - line)};
+      if (key.equalsIgnoreCase(name))
+      {
+        value = trim(colon + 1, lineEnd);
+        return true;
+      }
+    }
+    line = lineEnd + 1;
+  }
+
+  return false;
+}
+
+bool findQueryParam(const StringView &query, const char *name, StringView &value)
+{
+  size_t nameLength = strlen(name);
+  const char *pair = query.data;
+  const char *end = query.data + query.length;
+
+  while (pair < end)
+  {
+    const char *pairEnd = (const char *)memchr(pair, '&', end - pair);
+    if (pairEnd == NULL)
+      pairEnd = end;
+
+    if ((size_t)(pairEnd - pair) > nameLength && pair[nameLength] == '=' && memcmp(pair, name, nameLength) == 0)
+    {
+      value = {pair + nameLength + 1, (size_t)(pairEnd - pair - nameLength - 1)};
+      return true;
+    }
+    pair = pairEnd + 1;
+  }
+
+  return false;
+}
+
+bool parseHexByte(const StringView &text, uint8_t &value)
+{
+  const char *digits = text.data;
+  size_t count = text.length;
+  if (count > 2 && digits[0] == '0' && toLower(digits[1]) == 'x')
+  {
+    digits += 2;
+    count -= 2;
+  }
+
+  if (count == 0 || count > 2)
+    return false;
+
+  uint8_t result = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    int digit = hexDigit(digits[i]);
+    if (digit < 0)
+      return false;
+    result = (result << 4) | digit;
+  }
+
+  value = result;
+  return true;
+}
+
+bool parseUnsigned(const StringView &text, uint32_t &value)
+{
+  if (text.length == 0)
+    return false;
+
+  uint32_t result = 0;
+  for (size_t i = 0; i < text.length; i++)
+  {
+    char c = text.data[i];
+    if (c < '0' || c > '9')
+      return false;
+
+    uint32_t digit = c - '0';
+    if (result > (UINT32_MAX - digit) / 10)
+      return false;
+    result = result * 10 + digit;
+  }
+
+  value = result;
+  return true;
+}
@@ -0,0 +1,64 @@
+#ifndef HTTP_REQUEST_H
+#define HTTP_REQUEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_BUFFER_SIZE 1024 // Request head bytes kept; the rest of an oversized head is dropped
+
+// Non-owning view into the request buffer
+struct StringView
+{
+  const char *data;
+  size_t length;
+
+  bool equals(const char *text) const;
+  bool equalsIgnoreCase(const char *text) const;
+  bool containsIgnoreCase(const char *text) const;
+};
+
+// Tokens of a parsed request, all pointing into the request buffer
+struct HttpRequest
+{
+  StringView method;
+  StringView path;
+  StringView query;   // Without the leading '?', empty if absent
+  StringView headers; // Header lines following the request line
+};
+
+// Collects the request head (request line and headers) into a fixed buffer
+class HttpRequestBuffer
+{
+private:
+  char data[HTTP_BUFFER_SIZE];
+  size_t length;
+  uint8_t lineEnds; // Consecutive '\n' seen, ignoring '\r'
+  bool complete;
+  bool truncated;
+
+public:
+  HttpRequestBuffer();
+  void reset();
+  // Consumes bytes up to the blank line ending the head; returns bytes consumed
+  size_t append(const char *bytes, size_t count);
+  bool isComplete() const { return complete; }
+  bool isTruncated() const { return truncated; }
+  const char *begin() const { return data; }
+  size_t size() const { return length; }
+};
+
+// Splits the request line; false if it is missing or malformed
+bool parseRequest(const char *data, size_t length, HttpRequest &request);
+
+// Case-insensitive header lookup; value has surrounding whitespace removed
+bool findHeader(const HttpRequest &request, const char *name, StringView &value);
+
+// Finds name=value in a query string (no percent-decoding)
+bool findQueryParam(const StringView &query, const char *name, StringView &value);
+
+// Hex byte with optional 0x prefix, as printed by the dashboard
+bool parseHexByte(const StringView &text, uint8_t &value);
+
+bool parseUnsigned(const StringView &text, uint32_t &value);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef HTTP_ROUTES_H
+#define HTTP_ROUTES_H
+
+#include "HttpRequest.h"
+
+// One entry of a constexpr route table. Context carries whatever the handlers
+// need (client, managers, ...) so the table itself stays in flash.
+template <typename Context>
+struct Route
+{
+  const char *method;
+  const char *path;
+  void (*handler)(Context &context, const HttpRequest &request);
+};
+
+// Exact method and path match; NULL if no route applies
+template <typename Context, size_t N>
+const Route<Context> *findRoute(const Route<Context> (&routes)[N], const HttpRequest &request)
+{
+  for (size_t i = 0; i < N; i++)
+  {
+    if (request.method.equals(routes[i].method) && request.path.equals(routes[i].path))
+      return &routes[i];
+  }
+  return NULL;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "TelemetryExporter.h"
+#include <math.h>
+#include <string.h>
+
+TelemetryExporter::TelemetryExporter(DatagramSink &sink)
+    : sink(sink), controllerId(0), sequence(0), droppedPackets(0)
+{
+}
+
+void TelemetryExporter::setup(uint16_t controllerId)
+{
+  this->controllerId = controllerId;
+}
+
+bool TelemetryExporter::flush(TelemetryHeader &header, size_t length)
+{
+  header.sequence = sequence++;
+  encodeTelemetryHeader(packet, header);
+
+  bool sent = sink.send(packet, length);
+  if (!sent)
+    droppedPackets++;
+  return sent;
+}
+
+uint8_t TelemetryExporter::exportReadings(uint32_t timestamp, float temperature, float humidity,
+                                          const uint8_t *addresses, const DeviceStatusFrame *frames,
+                                          const bool *valid, size_t count)
+{
+  TelemetryHeader header;
+  header.controllerId = controllerId;
+  header.timestamp = timestamp;
+  header.temperature = isnan(temperature) ? TELEMETRY_UNKNOWN_TEMPERATURE : (int16_t)lroundf(temperature * 100);
+  header.humidity = isnan(humidity) ? TELEMETRY_UNKNOWN_HUMIDITY : (uint16_t)lroundf(humidity * 100);
+
+  uint8_t datagrams = 0;
+  size_t index = 0;
+  // Always send at least one datagram so collectors see the controller alive
+  do
+  {
+    size_t batch = count - index;
+    if (batch > TELEMETRY_MAX_RECORDS)
+      batch = TELEMETRY_MAX_RECORDS;
+
+    header.recordCount = batch;
+    size_t length = TELEMETRY_HEADER_SIZE;
+    for (size_t i = index; i < index + batch; i++)
+    {
+      // A failed read leaves stale or 0xFF-padded bytes in the frame, so only
+      // the address and a clear valid flag are sent for it
+      TelemetryRecord record;
+      memset(&record, 0, sizeof(record));
+      record.address = addresses[i];
+      if (!valid[i])
+      {
+        length += encodeTelemetryRecord(packet + length, record);
+        continue;
+      }
+
+      record.flags = TELEMETRY_FLAG_VALID;
+      if (frames[i].valveOpen)
+        record.flags |= TELEMETRY_FLAG_VALVE_OPEN;
+      record.status = frames[i].status;
+      record.lastCommandResult = frames[i].lastCommandResult;
+      record.moisture = frames[i].moisture;
+      record.errorCount = frames[i].errorCount;
+      record.uptimeSeconds = frames[i].uptimeSeconds;
+      record.flowPulses = frames[i].flowPulses;
+      length += encodeTelemetryRecord(packet + length, record);
+    }
+
+    if (flush(header, length))
+      datagrams++;
+    index += batch;
+  } while (index < count);
+
+  return datagrams;
+}
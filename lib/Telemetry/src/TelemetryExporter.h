@@ -0,0 +1,40 @@
+#ifndef TELEMETRY_EXPORTER_H
+#define TELEMETRY_EXPORTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "frames.h"
+#include "TelemetryPacket.h"
+
+// Transport for finished datagrams: WiFiUDP on the parent, a POSIX socket natively
+class DatagramSink
+{
+public:
+  virtual bool send(const uint8_t *data, size_t length) = 0;
+};
+
+// Packs cached sweep readings into sequence-numbered telemetry datagrams,
+// as many zones per datagram as TELEMETRY_MAX_PACKET allows.
+class TelemetryExporter
+{
+private:
+  DatagramSink &sink;
+  uint16_t controllerId;
+  uint32_t sequence;
+  uint32_t droppedPackets;
+  uint8_t packet[TELEMETRY_MAX_PACKET];
+
+  bool flush(TelemetryHeader &header, size_t length);
+
+public:
+  TelemetryExporter(DatagramSink &sink);
+  void setup(uint16_t controllerId);
+  // Returns the number of datagrams handed to the sink
+  uint8_t exportReadings(uint32_t timestamp, float temperature, float humidity,
+                         const uint8_t *addresses, const DeviceStatusFrame *frames,
+                         const bool *valid, size_t count);
+  uint32_t getSequence() const { return sequence; }
+  uint32_t getDroppedPackets() const { return droppedPackets; }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "TelemetryPacket.h"
+
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+  return p + 4;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+  return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+size_t encodeTelemetryHeader(uint8_t *buffer, const TelemetryHeader &header)
+{
+  uint8_t *p = put16(buffer, TELEMETRY_MAGIC);
+  *p++ = TELEMETRY_VERSION;
+  *p++ = header.recordCount;
+  p = put16(p, header.controllerId);
+  p = put32(p, header.sequence);
+  p = put32(p, header.timestamp);
+  p = put16(p, (uint16_t)header.temperature);
+  p = put16(p, header.humidity);
+  return p - buffer;
+}
+
+size_t encodeTelemetryRecord(uint8_t *buffer, const TelemetryRecord &record)
+{
+  uint8_t *p = buffer;
+  *p++ = record.address;
+  *p++ = record.flags;
+  *p++ = record.status;
+  *p++ = record.lastCommandResult;
+  p = put16(p, record.moisture);
+  p = put16(p, record.errorCount);
+  p = put32(p, record.uptimeSeconds);
+  p = put32(p, record.flowPulses);
+  return p - buffer;
+}
+
+int decodeTelemetry(const uint8_t *buffer, size_t length, TelemetryHeader &header,
+                    TelemetryRecord *records, size_t capacity)
+{
+  if (length < TELEMETRY_HEADER_SIZE || get16(buffer) != TELEMETRY_MAGIC || buffer[2] != TELEMETRY_VERSION)
+    return -1;
+
+  header.recordCount = buffer[3];
+  header.controllerId = get16(buffer + 4);
+  header.sequence = get32(buffer + 6);
+  header.timestamp = get32(buffer + 10);
+  header.temperature = (int16_t)get16(buffer + 14);
+  header.humidity = get16(buffer + 16);
+
+  if (length != TELEMETRY_HEADER_SIZE + (size_t)header.recordCount * TELEMETRY_RECORD_SIZE)
+    return -1;
+
+  size_t count = header.recordCount < capacity ? header.recordCount : capacity;
+  const uint8_t *p = buffer + TELEMETRY_HEADER_SIZE;
+  for (size_t i = 0; i < count; i++, p += TELEMETRY_RECORD_SIZE)
+  {
+    records[i].address = p[0];
+    records[i].flags = p[1];
+    records[i].status = p[2];
+    records[i].lastCommandResult = p[3];
+    records[i].moisture = get16(p + 4);
+    records[i].errorCount = get16(p + 6);
+    records[i].uptimeSeconds = get32(p + 8);
+    records[i].flowPulses = get32(p + 12);
+  }
+
+  return count;
+}
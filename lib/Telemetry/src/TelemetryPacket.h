@@ -0,0 +1,72 @@
+#ifndef TELEMETRY_PACKET_H
+#define TELEMETRY_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wire format, all fields little-endian. Decoded on the host by
+// tools/telemetry_collector.py, keep both in sync.
+//
+// Header (18 bytes)
+//   u16 magic        TELEMETRY_MAGIC
+//   u8  version      TELEMETRY_VERSION
+//   u8  recordCount
+//   u16 controllerId
+//   u32 sequence     Incremented for every datagram sent
+//   u32 timestamp    Unix seconds from the parent RTC
+//   i16 temperature  Hundredths of a degree C, TELEMETRY_UNKNOWN_TEMPERATURE if unread
+//   u16 humidity     Hundredths of a percent, TELEMETRY_UNKNOWN_HUMIDITY if unread
+//
+// Record (16 bytes each)
+//   u8  address
+//   u8  flags        TELEMETRY_FLAG_*
+//   u8  status       DeviceStatus
+//   u8  lastCommandResult
+//   u16 moisture
+//   u16 errorCount
+//   u32 uptimeSeconds
+//   u32 flowPulses
+
+#define TELEMETRY_MAGIC 0x5449 // "IT"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_SIZE 18
+#define TELEMETRY_RECORD_SIZE 16
+#define TELEMETRY_MAX_PACKET 512 // Well below the path MTU, no IP fragmentation
+#define TELEMETRY_MAX_RECORDS ((TELEMETRY_MAX_PACKET - TELEMETRY_HEADER_SIZE) / TELEMETRY_RECORD_SIZE)
+
+#define TELEMETRY_UNKNOWN_TEMPERATURE INT16_MIN
+#define TELEMETRY_UNKNOWN_HUMIDITY UINT16_MAX
+
+#define TELEMETRY_FLAG_VALID 0x01     // Child answered the last sweep
+#define TELEMETRY_FLAG_VALVE_OPEN 0x02
+
+struct TelemetryHeader
+{
+  uint8_t recordCount;
+  uint16_t controllerId;
+  uint32_t sequence;
+  uint32_t timestamp;
+  int16_t temperature;
+  uint16_t humidity;
+};
+
+struct TelemetryRecord
+{
+  uint8_t address;
+  uint8_t flags;
+  uint8_t status;
+  uint8_t lastCommandResult;
+  uint16_t moisture;
+  uint16_t errorCount;
+  uint32_t uptimeSeconds;
+  uint32_t flowPulses;
+};
+
+size_t encodeTelemetryHeader(uint8_t *buffer, const TelemetryHeader &header);
+size_t encodeTelemetryRecord(uint8_t *buffer, const TelemetryRecord &record);
+
+// Returns the number of records decoded, or -1 if the datagram is malformed
+int decodeTelemetry(const uint8_t *buffer, size_t length, TelemetryHeader &header,
+                    TelemetryRecord *records, size_t capacity);
+
+#endif
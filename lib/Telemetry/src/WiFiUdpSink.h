@@ -0,0 +1,28 @@
+#ifndef WIFI_UDP_SINK_H
+#define WIFI_UDP_SINK_H
+
+#include <WiFi101.h>
+#include <WiFiUdp.h>
+#include "TelemetryExporter.h"
+
+// Sends telemetry datagrams to a fixed collector (or broadcast) address
+class WiFiUdpSink : public DatagramSink
+{
+private:
+  WiFiUDP &udp;
+  const char *host;
+  uint16_t port;
+
+public:
+  WiFiUdpSink(WiFiUDP &udp, const char *host, uint16_t port) : udp(udp), host(host), port(port) {}
+
+  bool send(const uint8_t *data, size_t length)
+  {
+    if (!udp.beginPacket(host, port))
+      return false;
+    udp.write(data, length);
+    return udp.endPacket() == 1;
+  }
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "EventStream.h"
+#include <Arduino.h>
+#include "Web.h"
+
+// newlib-nano on the SAMD has no printf float support, so print tenths as integers
+static void formatTenths(char *out, size_t size, float value)
+{
+  long tenths = lroundf(value * 10);
+  unsigned long magnitude = tenths < 0 ? -tenths : tenths;
+  snprintf(out, size, "%s%lu.%lu", tenths < 0 ? "-" : "", magnitude / 10, magnitude % 10);
+}
+
+EventStream::EventStream()
+    : sentTemperature(0.0), sentHumidity(0.0), previousFlushMillis(0), previousWriteMillis(0), bufferLength(0)
+{
+  memset(sentAddresses, 0, sizeof(sentAddresses));
+}
+
+bool EventStream::attach(WiFiClient &client)
+{
+  for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++)
+  {
+    if (clients[i] && clients[i].connected())
+      continue;
+
+    clients[i].stop();
+    clients[i] = client;
+    clients[i].print("HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: keep-alive\r\n"
+                     "\r\n"
+                     "retry: 5000\n\n");
+    Serial.print("Event client attached, total ");
+    Serial.println(clientCount());
+    return true;
+  }
+
+  return false;
+}
+
+uint8_t EventStream::clientCount()
+{
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++)
+  {
+    if (clients[i] && clients[i].connected())
+      count++;
+  }
+  return count;
+}
+
+void EventStream::append(const char *event, const char *data)
+{
+  size_t needed = strlen(event) + strlen(data) + 17;
+  if (bufferLength + needed > EVENT_BUFFER_SIZE)
+    send();
+
+  bufferLength += snprintf(buffer + bufferLength, EVENT_BUFFER_SIZE - bufferLength,
+                           "event: %s\ndata: %s\n\n", event, data);
+}
+
+// Writes the pending events to every client in one write each
+void EventStream::send()
+{
+  if (bufferLength == 0)
+    return;
+
+  for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; i++)
+  {
+    if (!clients[i])
+      continue;
+
+    if (!clients[i].connected() || clients[i].write((const uint8_t *)buffer, bufferLength) != bufferLength)
+    {
+      clients[i].stop();
+      clients[i] = WiFiClient();
+      Serial.println("Event client detached");
+    }
+  }
+
+  bufferLength = 0;
+  previousWriteMillis = millis();
+}
+
+void EventStream::poll(DeviceManagement &deviceManager)
+{
+  unsigned long currentMillis = millis();
+  if (currentMillis - previousFlushMillis < EVENT_FLUSH_INTERVAL)
+    return;
+  previousFlushMillis = currentMillis;
+
+  if (clientCount() == 0)
+    return;
+
+  char data[48];
+  DeviceSweep devices = deviceManager.getLastSweep();
+  for (uint8_t i = 0; i < devices.size; i++)
+  {
+    if (!devices.valid[i])
+      continue;
+
+    const DeviceStatusFrame &frame = devices.frames[i];
+    bool known = sentAddresses[i] == devices.addresses[i];
+
+    if (!known || sentMoisture[i] != frame.moisture)
+    {
+      snprintf(data, sizeof(data), "{\"address\":%u,\"moisture\":%u}", devices.addresses[i], frame.moisture);
+      append("reading", data);
+      sentMoisture[i] = frame.moisture;
+    }
+
+    if (!known || sentValveOpen[i] != (bool)frame.valveOpen)
+    {
+      snprintf(data, sizeof(data), "{\"address\":%u,\"open\":%s}", devices.addresses[i], frame.valveOpen ? "true" : "false");
+      append("valve", data);
+      sentValveOpen[i] = frame.valveOpen;
+    }
+
+    sentAddresses[i] = devices.addresses[i];
+  }
+
+  if (!isnan(temperature) && !isnan(humidity) &&
+      (temperature != sentTemperature || humidity != sentHumidity))
+  {
+    char temperatureText[12];
+    char humidityText[12];
+    formatTenths(temperatureText, sizeof(temperatureText), temperature);
+    formatTenths(humidityText, sizeof(humidityText), humidity);
+    snprintf(data, sizeof(data), "{\"temperature\":%s,\"humidity\":%s}", temperatureText, humidityText);
+    append("environment", data);
+    sentTemperature = temperature;
+    sentHumidity = humidity;
+  }
+
+  // Comment line keeps idle connections open and detects dead clients
+  if (bufferLength == 0 && currentMillis - previousWriteMillis >= EVENT_KEEPALIVE_INTERVAL)
+  {
+    memcpy(buffer, ": ping\n\n", 8);
+    bufferLength = 8;
+  }
+
+  send();
+}
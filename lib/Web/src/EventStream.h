@@ -0,0 +1,38 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <WiFi101.h>
+#include "DeviceManagement.h"
+
+#define MAX_EVENT_CLIENTS 3          // WiFi101 only has a handful of TCP sockets
+#define EVENT_FLUSH_INTERVAL 1000    // Changes are coalesced and pushed at this rate
+#define EVENT_KEEPALIVE_INTERVAL 15000
+#define EVENT_BUFFER_SIZE 256
+
+// Server-Sent Events channel. Keeps a few long-lived clients open and pushes
+// only readings that changed in the device sweep cache since the last flush.
+class EventStream
+{
+private:
+  WiFiClient clients[MAX_EVENT_CLIENTS];
+  uint8_t sentAddresses[MAX_DEVICES];
+  uint16_t sentMoisture[MAX_DEVICES];
+  bool sentValveOpen[MAX_DEVICES];
+  float sentTemperature;
+  float sentHumidity;
+  unsigned long previousFlushMillis;
+  unsigned long previousWriteMillis;
+  char buffer[EVENT_BUFFER_SIZE];
+  size_t bufferLength;
+
+  uint8_t clientCount();
+  void append(const char *event, const char *data);
+  void send();
+
+public:
+  EventStream();
+  bool attach(WiFiClient &client);
+  void poll(DeviceManagement &deviceManager);
+};
+
+#endif
@@ -1,170 +1,405 @@
 #include "Web.h"
 #include <Arduino.h>
-#include <Wire.h>
+#include <ArduinoJson.h>
+#include "config.h"
 #include "enums.h"
+#include "StatusJson.h"
+#include "WebAssets.h"
+#include "MemoryStats.h"
 
-// Helper function to extract query parameter value from URL
-uint8_t getQueryParam(String url, String paramName)
+#define REQUEST_TIMEOUT 500 // ms allowed for the request head, so a stalled client can't block loop()
+#define LOG_DEFAULT_WINDOW 3600 // Seconds of history /api/log returns when from is omitted
+#define LOG_MAX_RECORDS 5000    // Records per /api/log response; page on with from=<last timestamp + 1>
+
+char jsonBuffer[JSON_BUFFER_SIZE];
+
+// Handlers receive views into requestBuffer, so nothing is copied per request
+void handleEvents(WebContext &context, const HttpRequest &request)
+{
+  (void)request;
+  context.keepOpen = context.events.attach(context.client);
+  if (!context.keepOpen)
+    sendEmptyResponse(context.client, "503 Service Unavailable");
+}
+
+void handleStatus(WebContext &context, const HttpRequest &request)
+{
+  (void)request;
+  sendStatusJson(context.client, context.deviceManager);
+}
+
+void handleMetrics(WebContext &context, const HttpRequest &request)
+{
+  (void)request;
+  sendMetrics(context.client, context.deviceManager);
+}
+
+// GET /api/log?from=<unix>&to=<unix>, both optional; without from only the
+// last LOG_DEFAULT_WINDOW seconds are returned
+void handleLog(WebContext &context, const HttpRequest &request)
 {
-  int paramIndex = url.indexOf(paramName + "=");
-  if (paramIndex == -1)
+  if (context.dataLog == NULL)
   {
-    return 0; // Parameter not found
+    sendEmptyResponse(context.client, "503 Service Unavailable");
+    return;
   }
 
-  int valueStart = paramIndex + paramName.length() + 1;
-  int valueEnd = url.indexOf('&', valueStart);
-  if (valueEnd == -1)
+  StringView param;
+  uint32_t last = context.dataLog->getLastTimestamp();
+  uint32_t from = last > LOG_DEFAULT_WINDOW ? last - LOG_DEFAULT_WINDOW : 0;
+  uint32_t to = UINT32_MAX;
+  if ((findQueryParam(request.query, "from", param) && !parseUnsigned(param, from)) ||
+      (findQueryParam(request.query, "to", param) && !parseUnsigned(param, to)))
   {
-    valueEnd = url.indexOf(' ', valueStart); // Space marks end of URL
+    sendEmptyResponse(context.client, "400 Bad Request");
+    return;
   }
 
-  return url.substring(valueStart, valueEnd).toInt();
+  sendLogCsv(context.client, *context.dataLog, from, to);
 }
 
-void sendDeviceCommand(String addressParam, DeviceAction action)
+template <DeviceAction action>
+void handleCommand(WebContext &context, const HttpRequest &request)
 {
-  if (addressParam.length() > 0)
+  StringView param;
+  uint8_t address;
+  if (!findQueryParam(request.query, "address", param) || !parseHexByte(param, address))
   {
-    // Convert hex string to byte
-    uint8_t targetAddress = (uint8_t)strtol(addressParam.c_str(), NULL, 16);
-    Wire.beginTransmission(targetAddress);
-    Wire.write(action);
-    Wire.endTransmission();
-  }
-  else
-  {
-    Serial.println("Error: No address provided for START command");
+    sendEmptyResponse(context.client, "400 Bad Request");
+    return;
   }
+
+  context.deviceManager.sendDeviceCommand(address, action);
+  // The dashboard and event stream see the new state without waiting for the next sweep
+  context.deviceManager.refreshDevice(address);
+  sendEmptyResponse(context.client, "204 No Content");
 }
 
-void printWeb(WiFiClient &client, DeviceManagement &deviceManager)
+constexpr Route<WebContext> routes[] = {
+    {"GET", "/events", handleEvents},
+    {"GET", "/api/status", handleStatus},
+    {"GET", "/api/log", handleLog},
+    {"GET", "/metrics", handleMetrics},
+    {"GET", "/START", handleCommand<DEVICE_ACTIVATE>},
+    {"GET", "/STOP", handleCommand<DEVICE_DEACTIVATE>},
+    {"GET", "/IDENTIFY", handleCommand<DEVICE_IDENTIFY>},
+    {"GET", "/SLEEP", handleCommand<DEVICE_SLEEP>},
+};
+
+HttpRequestBuffer requestBuffer;
+
+void printWeb(WiFiClient &client, DeviceManagement &deviceManager, EventStream &events, DataLog *dataLog)
 {
   if (!client)
     return;
 
-  Serial.println("new client"); // print a message out the serial port
-  String currentLine = "";      // make a String to hold incoming data from the client
-  while (client.connected())
-  { // loop while the client's connected
-    if (client.available())
-    {                         // if there's bytes to read from the client,
-      char c = client.read(); // read a byte, then
-      Serial.write(c);        // print it out the serial monitor
-      if (c == '\n')
-      { // if the byte is a newline character
-
-        // if the current line is blank, you got two newline characters in a row.
-        // that's the end of the client HTTP request, so send a response:
-        if (currentLine.length() == 0)
-        {
-
-          // HTTP headers always start with a response code (e.g. HTTP/1.1 200 OK)
-          // and a content-type so the client knows what's coming, then a blank line:
-          client.println("HTTP/1.1 200 OK");
-          client.println("Content-type:text/html");
-          client.println();
-
-          // Ping known devices and display moisture data
-          listConnectedDevices(client, deviceManager);
-          listTemperatureHumidity(client);
-
-          // The HTTP response ends with another blank line:
-          client.println();
-          // break out of the while loop:
-          break;
-        }
-        else
-        { // if you got a newline, then process the complete line
-          // Check for commands only when we have a complete line
-          if (currentLine.startsWith("GET /START"))
-          {
-            uint8_t addressParam = getQueryParam(currentLine, "address");
-            deviceManager.sendDeviceCommand(addressParam, DEVICE_ACTIVATE);
-          }
-          else if (currentLine.startsWith("GET /STOP"))
-          {
-            uint8_t addressParam = getQueryParam(currentLine, "address");
-            deviceManager.sendDeviceCommand(addressParam, DEVICE_DEACTIVATE);
-          }
-          else if (currentLine.startsWith("GET /IDENTIFY"))
-          {
-            uint8_t addressParam = getQueryParam(currentLine, "address");
-            deviceManager.sendDeviceCommand(addressParam, DEVICE_IDENTIFY);
-          }
-          else if (currentLine.startsWith("GET /SLEEP"))
-          {
-            uint8_t addressParam = getQueryParam(currentLine, "address");
-            deviceManager.sendDeviceCommand(addressParam, DEVICE_SLEEP);
-          }
-
-          currentLine = ""; // clear currentLine
-        }
-      }
-      else if (c != '\r')
-      {                   // if you got anything else but a carriage return character,
-        currentLine += c; // add it to the end of the currentLine
-      }
+  Serial.println("new client");
+  requestBuffer.reset();
+
+  char chunk[64];
+  unsigned long startMillis = millis();
+  bool timedOut = false;
+  while (client.connected() && !requestBuffer.isComplete())
+  {
+    if (millis() - startMillis >= REQUEST_TIMEOUT)
+    {
+      timedOut = true;
+      break;
+    }
+
+    int available = client.available();
+    if (available > 0)
+    {
+      int count = client.read((uint8_t *)chunk, available < (int)sizeof(chunk) ? available : sizeof(chunk));
+      if (count > 0)
+        requestBuffer.append(chunk, count);
+    }
+  }
+
+  WebContext context = {client, deviceManager, events, dataLog, false};
+  HttpRequest request;
+
+  if (timedOut)
+  {
+    Serial.println("request timed out");
+    sendEmptyResponse(client, "408 Request Timeout");
+  }
+  // Nothing to answer if the client went away mid-request
+  else if (requestBuffer.isComplete())
+  {
+    if (parseRequest(requestBuffer.begin(), requestBuffer.size(), request))
+    {
+      Serial.write((const uint8_t *)request.method.data, request.method.length);
+      Serial.print(" ");
+      Serial.write((const uint8_t *)request.path.data, request.path.length);
+      Serial.println();
+      handleRequest(context, request);
+    }
+    else
+    {
+      sendEmptyResponse(client, "400 Bad Request");
     }
   }
+
+  // Keep the connection open when it was handed to the event stream
+  if (context.keepOpen)
+    return;
+
   // close the connection:
   client.stop();
   Serial.println("client disconnected");
 }
 
-void listTemperatureHumidity(WiFiClient &client)
+void handleRequest(WebContext &context, const HttpRequest &request)
 {
-  client.print("<h2>Current Environmental Data</h2>");
-  client.print("<ul>");
-  client.print("<li><pre>Temperature: ");
-  client.print(temperature);
-  client.print(" &deg;C</pre></li>");
-  client.print("<li><pre>Humidity: ");
-  client.print(humidity);
-  client.print(" %</pre></li>");
-  client.print("</ul>");
-}
+  const Route<WebContext> *route = findRoute(routes, request);
+  if (route)
+  {
+    route->handler(context, request);
+    return;
+  }
 
-void listConnectedDevices(WiFiClient &client, DeviceManagement &deviceManager)
-{
-  client.print("<h2>Connected I2C Devices Moisture Readings</h2>");
+  const WebAsset *asset = NULL;
+  if (request.method.equals("GET"))
+    asset = findWebAsset(request.path.data, request.path.length);
 
-  DeviceBuffer devices = deviceManager.getConnectedDevices();
-  if (devices.size > 0)
+  if (asset)
   {
-    client.print("<h3>Device Moisture Readings</h3>");
-
-    client.print("<ul>");
-    for (uint8_t i = 0; i < devices.size; i++)
+    // Assets are only stored gzipped; a missing header means any encoding is acceptable
+    StringView acceptEncoding;
+    if (findHeader(request, "Accept-Encoding", acceptEncoding) && !acceptEncoding.containsIgnoreCase("gzip"))
     {
-      byte address = devices.data[i];
-      String data = deviceManager.getDeviceData(address);
-
-      client.print("<li><pre>Device 0x");
-      if (address < 16)
-      {
-        client.print("0");
-      }
-      client.print(address, HEX);
-      client.print(": ");
-      client.print(data);
-      client.print("</pre>");
-      client.print("<a href=\"/START?address=" + String(address, HEX) + "\">Start</a>");
-      client.print(" | ");
-      client.print("<a href=\"/STOP?address=" + String(address, HEX) + "\">Stop</a>");
-      client.print(" | ");
-      client.print("<a href=\"/IDENTIFY?address=" + String(address, HEX) + "\">Identify</a>");
-      client.print(" | ");
-      client.print("<a href=\"/SLEEP?address=" + String(address, HEX) + "\">Sleep</a>");
-      client.print("</li>");
+      sendTextResponse(context.client, "406 Not Acceptable", "This asset is only available gzip-encoded\n");
+      return;
     }
-    client.print("</ul>");
+
+    StringView ifNoneMatch = {"", 0};
+    findHeader(request, "If-None-Match", ifNoneMatch);
+    sendAsset(context.client, *asset, ifNoneMatch);
   }
   else
   {
-    client.print("No devices connected<br>");
+    sendEmptyResponse(context.client, "404 Not Found");
+  }
+}
+
+void sendEmptyResponse(WiFiClient &client, const char *status)
+{
+  char header[96];
+  int length = snprintf(header, sizeof(header),
+                        "HTTP/1.1 %s\r\n"
+                        "Content-Length: 0\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        status);
+  client.write((const uint8_t *)header, length);
+}
+
+void sendTextResponse(WiFiClient &client, const char *status, const char *text)
+{
+  char header[128];
+  int length = snprintf(header, sizeof(header),
+                        "HTTP/1.1 %s\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Length: %u\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        status, (unsigned)strlen(text));
+  client.write((const uint8_t *)header, length);
+  client.write((const uint8_t *)text, strlen(text));
+}
+
+void sendAsset(WiFiClient &client, const WebAsset &asset, const StringView &ifNoneMatch)
+{
+  char header[320];
+  int length;
+
+  // Browser copy is current: answer with headers only
+  if (ifNoneMatch.equals(asset.etag))
+  {
+    length = snprintf(header, sizeof(header),
+                      "HTTP/1.1 304 Not Modified\r\n"
+                      "ETag: %s\r\n"
+                      "Cache-Control: %s\r\n"
+                      "Connection: close\r\n"
+                      "\r\n",
+                      asset.etag, asset.cacheControl);
+    client.write((const uint8_t *)header, length);
+    return;
+  }
+
+  length = snprintf(header, sizeof(header),
+                    "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: %s\r\n"
+                    "Content-Encoding: gzip\r\n"
+                    "Content-Length: %u\r\n"
+                    "ETag: %s\r\n"
+                    "Cache-Control: %s\r\n"
+                    "Vary: Accept-Encoding\r\n"
+                    "Connection: close\r\n"
+                    "\r\n",
+                    asset.contentType, (unsigned)asset.size, asset.etag, asset.cacheControl);
+  client.write((const uint8_t *)header, length);
+
+  // Flash is memory-mapped on the SAMD21, so chunks are written straight from it
+  for (size_t offset = 0; offset < asset.size; offset += ASSET_CHUNK_SIZE)
+  {
+    size_t chunk = asset.size - offset;
+    if (chunk > ASSET_CHUNK_SIZE)
+      chunk = ASSET_CHUNK_SIZE;
+
+    if (client.write(asset.data + offset, chunk) != chunk)
+      break;
+  }
+}
+
+void sendStatusJson(WiFiClient &client, DeviceManagement &deviceManager)
+{
+  JsonDocument doc;
+  buildStatusJson(doc, deviceManager.getLastSweep(), temperature, humidity);
+
+  // serializeJson truncates silently, which would send invalid JSON
+  if (measureJson(doc) >= sizeof(jsonBuffer))
+  {
+    Serial.println("Status JSON exceeds JSON_BUFFER_SIZE");
+    sendTextResponse(client, "500 Internal Server Error", "Status exceeds JSON_BUFFER_SIZE\n");
+    return;
+  }
+  size_t bodyLength = serializeJson(doc, jsonBuffer, sizeof(jsonBuffer));
+
+  char header[128];
+  int length = snprintf(header, sizeof(header),
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: application/json\r\n"
+                        "Content-Length: %u\r\n"
+                        "Cache-Control: no-store\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        (unsigned)bodyLength);
+  client.write((const uint8_t *)header, length);
+  client.write((const uint8_t *)jsonBuffer, bodyLength);
+}
+
+#define LOG_LINE_SIZE 64    // Longest CSV line written by writeLogRecord
+#define METRIC_LINE_SIZE 80 // Longest sample line written by writeMetric
+
+// Streamed bodies are batched into jsonBuffer, which is free while streaming
+struct ResponseStream
+{
+  WiFiClient &client;
+  size_t length;
+  uint32_t lines;
+};
+
+// False once the client stops accepting data
+bool flushResponseStream(ResponseStream &stream)
+{
+  bool written = stream.client.write((const uint8_t *)jsonBuffer, stream.length) == stream.length;
+  stream.length = 0;
+  return written;
+}
+
+bool reserveResponseStream(ResponseStream &stream, size_t lineSize)
+{
+  if (stream.length + lineSize > JSON_BUFFER_SIZE)
+    return flushResponseStream(stream);
+  return true;
+}
+
+// Ends the query at the record cap or when the client has gone away, so no
+// more blocks are read from the card for nobody
+bool writeLogRecord(const LogRecord &record, void *context)
+{
+  ResponseStream &stream = *(ResponseStream *)context;
+  if (stream.lines >= LOG_MAX_RECORDS || !reserveResponseStream(stream, LOG_LINE_SIZE))
+    return false;
+  stream.lines++;
+
+  stream.length += snprintf(jsonBuffer + stream.length, LOG_LINE_SIZE, "%lu,%s,%u,%u,%u,%u,%lu,%u\n",
+                            (unsigned long)record.timestamp, record.type == LOG_VALVE_EVENT ? "valve" : "reading",
+                            record.address, record.status, record.moisture, record.valveOpen,
+                            (unsigned long)record.flowPulses, record.errorCount);
+  return true;
+}
+
+void sendLogCsv(WiFiClient &client, DataLog &dataLog, uint32_t from, uint32_t to)
+{
+  // No Content-Length: the body ends when the connection closes
+  ResponseStream stream = {client, 0, 0};
+  stream.length = snprintf(jsonBuffer, JSON_BUFFER_SIZE,
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/csv\r\n"
+                           "Cache-Control: no-store\r\n"
+                           "Connection: close\r\n"
+                           "\r\n"
+                           "timestamp,type,address,status,moisture,valve_open,flow_pulses,errors\n");
+
+  dataLog.query(from, to, writeLogRecord, &stream);
+  flushResponseStream(stream);
+}
+
+void writeMetric(ResponseStream &stream, const char *node, const char *kind, uint32_t value)
+{
+  reserveResponseStream(stream, METRIC_LINE_SIZE);
+  stream.length += snprintf(jsonBuffer + stream.length, METRIC_LINE_SIZE,
+                            "irrigation_memory_bytes{node=\"%s\",kind=\"%s\"} %lu\n",
+                            node, kind, (unsigned long)value);
+}
+
+void writeMemoryMetrics(ResponseStream &stream, const char *node, const MemoryStats &stats)
+{
+  writeMetric(stream, node, "ram", stats.ramSize);
+  writeMetric(stream, node, "static", stats.staticSize);
+  writeMetric(stream, node, "heap", stats.heapSize);
+  writeMetric(stream, node, "heap_high_water", stats.heapHighWater);
+  writeMetric(stream, node, "stack_high_water", stats.stackHighWater);
+  writeMetric(stream, node, "free", stats.freeNow);
+  writeMetric(stream, node, "free_min", stats.freeMin);
+}
+
+void sendMetrics(WiFiClient &client, DeviceManagement &deviceManager)
+{
+  ResponseStream stream = {client, 0, 0};
+  stream.length = snprintf(jsonBuffer, JSON_BUFFER_SIZE,
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Cache-Control: no-store\r\n"
+                           "Connection: close\r\n"
+                           "\r\n"
+                           "# HELP irrigation_memory_bytes RAM use per node, high-water marks since boot\n"
+                           "# TYPE irrigation_memory_bytes gauge\n");
+
+  writeMemoryMetrics(stream, "parent", getMemoryStats());
+
+  // One diagnostics read per child; the next sweep reselects their status frames
+  DeviceSweep devices = deviceManager.getLastSweep();
+  bool reachable[MAX_DEVICES];
+  for (uint8_t i = 0; i < devices.size; i++)
+  {
+    char node[8];
+    snprintf(node, sizeof(node), "0x%02X", devices.addresses[i]);
+
+    DeviceMemoryFrame frame;
+    reachable[i] = deviceManager.getDeviceMemory(devices.addresses[i], frame);
+    if (!reachable[i])
+      continue;
+
+    MemoryStats stats = {frame.ramSize, frame.staticSize, frame.heapSize, frame.heapHighWater,
+                         frame.stackHighWater, frame.freeNow, frame.freeMin};
+    writeMemoryMetrics(stream, node, stats);
+  }
+
+  reserveResponseStream(stream, 2 * METRIC_LINE_SIZE);
+  stream.length += snprintf(jsonBuffer + stream.length, 2 * METRIC_LINE_SIZE,
+                            "# HELP irrigation_diagnostics_up Child answered DEVICE_DIAGNOSTICS\n"
+                            "# TYPE irrigation_diagnostics_up gauge\n");
+  for (uint8_t i = 0; i < devices.size; i++)
+  {
+    reserveResponseStream(stream, METRIC_LINE_SIZE);
+    stream.length += snprintf(jsonBuffer + stream.length, METRIC_LINE_SIZE,
+                              "irrigation_diagnostics_up{node=\"0x%02X\"} %u\n",
+                              devices.addresses[i], reachable[i] ? 1 : 0);
   }
 
-  // Free allocated memory
-  delete[] devices.data;
-}
\ No newline at end of file
+  flushResponseStream(stream);
+}
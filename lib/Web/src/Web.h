@@ -3,17 +3,43 @@
 
 #include <WiFi101.h>
 #include "DeviceManagement.h"
+#include "EventStream.h"
+#include "WebAssets.h"
+#include "HttpRequest.h"
+#include "HttpRoutes.h"
+#include "DataLog.h"
 
 extern float temperature;
 extern float humidity;
 
-void printWeb(WiFiClient &client, DeviceManagement &deviceManager);
+// State shared by the route handlers for one request
+struct WebContext
+{
+  WiFiClient &client;
+  DeviceManagement &deviceManager;
+  EventStream &events;
+  DataLog *dataLog; // NULL when no SD card is present
+  bool keepOpen; // Set when the connection was handed to the event stream
+};
 
-void listTemperatureHumidity(WiFiClient &client);
+void printWeb(WiFiClient &client, DeviceManagement &deviceManager, EventStream &events, DataLog *dataLog);
 
-void listConnectedDevices(WiFiClient &client, DeviceManagement &deviceManager);
+// Dispatches through the route table, falling back to the embedded assets
+void handleRequest(WebContext &context, const HttpRequest &request);
 
-// Helper function to extract query parameter value
-uint8_t getQueryParam(String url, String paramName);
+void sendEmptyResponse(WiFiClient &client, const char *status);
+
+void sendTextResponse(WiFiClient &client, const char *status, const char *text);
+
+void sendAsset(WiFiClient &client, const WebAsset &asset, const StringView &ifNoneMatch);
+
+void sendStatusJson(WiFiClient &client, DeviceManagement &deviceManager);
+
+// Streams up to LOG_MAX_RECORDS log records in [from, to] as CSV without
+// buffering the result; stops early if the client disconnects
+void sendLogCsv(WiFiClient &client, DataLog &dataLog, uint32_t from, uint32_t to);
+
+// Prometheus text exposition of parent and child memory diagnostics
+void sendMetrics(WiFiClient &client, DeviceManagement &deviceManager);
 
 #endif
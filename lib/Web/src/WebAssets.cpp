@@ -0,0 +1,19 @@
+#include "WebAssets.h"
+#include <string.h>
+
+const WebAsset *findWebAsset(const char *path, size_t length)
+{
+  if (length == 1 && path[0] == '/')
+  {
+    path = "/index.html";
+    length = strlen(path);
+  }
+
+  for (size_t i = 0; i < webAssetCount; i++)
+  {
+    if (strlen(webAssets[i].path) == length && strncmp(webAssets[i].path, path, length) == 0)
+      return &webAssets[i];
+  }
+
+  return NULL;
+}
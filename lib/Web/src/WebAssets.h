@@ -0,0 +1,26 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_CHUNK_SIZE 1024 // Bytes per client.write(), below the WiFi101 socket MTU
+
+// Gzip-compressed dashboard file embedded in flash by tools/embed_assets.py
+struct WebAsset
+{
+  const char *path;
+  const char *contentType;
+  const char *etag; // Quoted, ready for the ETag header
+  const char *cacheControl;
+  const uint8_t *data;
+  size_t size;
+};
+
+extern const WebAsset webAssets[];
+extern const size_t webAssetCount;
+
+// Looks up an asset by request path; "/" maps to "/index.html"
+const WebAsset *findWebAsset(const char *path, size_t length);
+
+#endif
@@ -4,6 +4,8 @@
 
 #include "config.h"
 #include "enums.h"
+#include "frames.h"
+#include "MemoryStats.h"
 
 #define DEFAULT_ADDRESS 0x00 // Default unassigned address (general call)
 #define MAX_RESPONSE_SIZE 31 // Maximum response data size (32 - 1 for length byte)
@@ -17,6 +19,20 @@ const long interval = 250;
 int valvePin = 2;
 bool valveActive = false;
 
+int flowPin = 3; // Flow sensor input pin (INT1)
+volatile uint32_t flowPulses = 0;
+
+int moisturePin = A0;
+volatile uint16_t moistureValue = 0;
+unsigned long previousMoistureMillis = 0;
+const long moistureInterval = 1000;
+
+volatile uint8_t lastCommandResult = COMMAND_NONE;
+volatile uint16_t errorCount = 0;
+
+DeviceMemoryFrame memoryFrame; // Refreshed by loop(), sent by the request ISR
+unsigned long previousMemoryMillis = 0;
+
 JsonDocument doc;
 uint8_t currentAddress = DEFAULT_ADDRESS;
 bool addressAssigned = false;
@@ -37,14 +53,46 @@ void sendResponse(const char *data)
 
 void sendCurrentMoisture()
 {
-  // Read analog value from A0 (0-1023 range)
-  int moistureValue = analogRead(A0);
+  // Latest A0 sample taken by loop() (0-1023 range)
   doc["moisture"] = moistureValue;
   char moistureBuffer[50];
   serializeJson(doc, moistureBuffer);
   sendResponse(moistureBuffer);
 }
 
+// Answered from values cached by loop() so the request ISR stays short
+void sendStatusFrame()
+{
+  DeviceStatusFrame frame;
+  frame.status = currentStatus;
+  frame.moisture = moistureValue;
+  frame.valveOpen = valveActive;
+  frame.uptimeSeconds = millis() / 1000;
+  frame.flowPulses = flowPulses;
+  frame.lastCommandResult = lastCommandResult;
+  frame.errorCount = errorCount;
+  sealFrame(frame);
+
+  Wire.write((uint8_t *)&frame, sizeof(frame));
+}
+
+void sendMemoryFrame()
+{
+  Wire.write((uint8_t *)&memoryFrame, sizeof(memoryFrame));
+}
+
+void countFlowPulse()
+{
+  flowPulses++;
+}
+
+void recordError(CommandResult result)
+{
+  lastCommandResult = result;
+  if (errorCount < UINT16_MAX)
+    errorCount++;
+}
+
 void handleAction(DeviceAction action)
 {
   switch (action)
@@ -53,6 +101,12 @@ void handleAction(DeviceAction action)
     Serial.println("Sending STATUS response");
     sendCurrentMoisture();
     break;
+  case DEVICE_BULK_STATUS:
+    sendStatusFrame();
+    break;
+  case DEVICE_DIAGNOSTICS:
+    sendMemoryFrame();
+    break;
   case DEVICE_ACTIVATE:
     Serial.println("Starting irrigation (simulated)");
     sendResponse("Irrigation started");
@@ -101,8 +155,23 @@ void receiveEvent(int numBytes)
 
   currentAction = (DeviceAction)Wire.read();
 
+  if (currentAction > DEVICE_DIAGNOSTICS)
+  {
+    recordError(COMMAND_UNKNOWN);
+  }
+  else if (currentAction >= DEVICE_ACTIVATE && currentAction <= DEVICE_SLEEP)
+  {
+    lastCommandResult = COMMAND_OK;
+  }
+
   if (currentAction == DEVICE_ASSIGN_ADDRESS)
   {
+    if (numBytes < 2)
+    {
+      recordError(COMMAND_MALFORMED);
+      return;
+    }
+
     uint8_t newAddress = Wire.read();
     currentAddress = newAddress;
     addressAssigned = true;
@@ -124,9 +193,14 @@ void receiveEvent(int numBytes)
 
 void setup()
 {
+  paintStack();
+  fillMemoryFrame(memoryFrame);
   pinMode(ledPin, OUTPUT);
   pinMode(valvePin, OUTPUT);
   digitalWrite(valvePin, LOW);
+  pinMode(flowPin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(flowPin), countFlowPulse, RISING);
+  moistureValue = analogRead(moisturePin);
   Serial.begin(SERIAL_BAUD_RATE);
   Serial.println("I2C Slave starting...");
 
@@ -154,6 +228,26 @@ void loop()
 
   unsigned long currentMillis = millis();
 
+  if (currentMillis - previousMoistureMillis >= moistureInterval)
+  {
+    previousMoistureMillis = currentMillis;
+    uint16_t sample = analogRead(moisturePin);
+    noInterrupts();
+    moistureValue = sample;
+    interrupts();
+  }
+
+  if (currentMillis - previousMemoryMillis >= MEMORY_SAMPLE_INTERVAL)
+  {
+    previousMemoryMillis = currentMillis;
+    sampleMemory();
+    DeviceMemoryFrame frame;
+    fillMemoryFrame(frame);
+    noInterrupts();
+    memoryFrame = frame;
+    interrupts();
+  }
+
   if (currentMillis - previousMillis >= interval)
   {
     // save the last time you blinked the LED
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "HttpRequest.h"
+#include "HttpRoutes.h"
+
+#define SOCKET_READ_SIZE 64 // Matches the chunk size printWeb reads from WiFiClient
+
+// Typical requests seen by the parent: a dashboard revalidation and a command
+const char *dashboardRequest =
+    "GET / HTTP/1.1\r\n"
+    "Host: irrigation-system.local\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "If-None-Match: \"9232a89bab0822f0\"\r\n"
+    "\r\n";
+
+const char *commandRequest =
+    "GET /START?address=0a HTTP/1.1\r\n"
+    "Host: irrigation-system.local\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36\r\n"
+    "Accept: */*\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "\r\n";
+
+struct BenchContext
+{
+  uint32_t hits;
+};
+
+void countHit(BenchContext &context, const HttpRequest &request)
+{
+  StringView param;
+  uint8_t address;
+  if (findQueryParam(request.query, "address", param) && parseHexByte(param, address))
+    context.hits += address;
+  else
+    context.hits++;
+}
+
+constexpr Route<BenchContext> benchRoutes[] = {
+    {"GET", "/events", countHit},
+    {"GET", "/api/status", countHit},
+    {"GET", "/START", countHit},
+    {"GET", "/STOP", countHit},
+    {"GET", "/IDENTIFY", countHit},
+    {"GET", "/SLEEP", countHit},
+};
+
+// Buffering, tokenizing, dispatch and header lookup, as printWeb does them
+uint32_t handleOnce(HttpRequestBuffer &buffer, const char *text, size_t length, BenchContext &context)
+{
+  buffer.reset();
+  for (size_t offset = 0; offset < length && !buffer.isComplete(); offset += SOCKET_READ_SIZE)
+  {
+    size_t count = length - offset < SOCKET_READ_SIZE ? length - offset : SOCKET_READ_SIZE;
+    buffer.append(text + offset, count);
+  }
+
+  HttpRequest request;
+  if (!parseRequest(buffer.begin(), buffer.size(), request))
+    return 0;
+
+  const Route<BenchContext> *route = findRoute(benchRoutes, request);
+  if (route)
+  {
+    route->handler(context, request);
+    return 1;
+  }
+
+  StringView etag;
+  return findHeader(request, "If-None-Match", etag) ? (uint32_t)etag.length : 0;
+}
+
+int benchHttp(unsigned long iterations)
+{
+  static HttpRequestBuffer buffer;
+  const char *requests[] = {dashboardRequest, commandRequest};
+  const char *names[] = {"dashboard", "command"};
+
+  printf("HTTP parse throughput, %lu iterations\n", iterations);
+  for (size_t r = 0; r < 2; r++)
+  {
+    size_t length = strlen(requests[r]);
+    BenchContext context = {0};
+    uint32_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+      checksum += handleOnce(buffer, requests[r], length, context);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("  %-10s %4zu bytes  %8.1f ns/request  %10.0f requests/s  %8.1f MB/s  (check %u)\n",
+           names[r], length, elapsed * 1e9 / iterations, iterations / elapsed,
+           length * iterations / elapsed / 1e6, checksum + context.hits);
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  return benchHttp(argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000);
+}
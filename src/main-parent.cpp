@@ -10,16 +10,39 @@
 #include "Web.h"
 #include "MDNS.h"
 #include "DeviceManagement.h"
+#include "EventStream.h"
+#include "TelemetryExporter.h"
+#include "WiFiUdpSink.h"
+#include "DataLog.h"
+#include "SdLogStorage.h"
+#include "MemoryStats.h"
 
 WiFiServer server(80);
 WiFiClient client = server.available();
 MDNS mdns;
 DeviceManagement deviceManager;
+EventStream events;
+
+unsigned long previousSweepMillis = 0;
 
 WiFiUDP ntpUDP;
 NTPClient timeClient(ntpUDP);
 RTCZero rtc;
 
+WiFiUDP telemetryUDP;
+WiFiUdpSink telemetrySink(telemetryUDP, TELEMETRY_HOST, TELEMETRY_PORT);
+TelemetryExporter telemetry(telemetrySink);
+unsigned long previousTelemetryMillis = 0;
+
+SdLogStorage logStorage;
+DataLog dataLog(logStorage);
+bool dataLogReady = false;
+bool dataLogFailing = false; // Writes are failing; buffered records are retried every sweep
+bool loggedValveOpen[MAX_DEVICES];
+unsigned long previousLogMillis = 0;
+
+unsigned long previousMemoryMillis = 0;
+
 #define DHTPIN 0      // Pin which is connected to the DHT sensor
 #define DHTTYPE DHT22 // DHT 22 (AM2302)
 DHT dht(DHTPIN, DHTTYPE);
@@ -40,6 +63,7 @@ void setRTCFromNTP()
 
 void setup()
 {
+  paintStack();
   Serial.begin(SERIAL_BAUD_RATE);
   while (!Serial)
     ;
@@ -49,6 +73,7 @@ void setup()
 
   // Setup Device Management
   deviceManager.setup();
+  deviceManager.sweepDevices();
 
   dht.begin();
 
@@ -57,6 +82,81 @@ void setup()
   rtc.begin();
 
   setRTCFromNTP();
+
+  // Identify this controller to collectors by the low bytes of its MAC
+  byte mac[6];
+  WiFi.macAddress(mac);
+  telemetryUDP.begin(TELEMETRY_LOCAL_PORT);
+  telemetry.setup((mac[1] << 8) | mac[0]);
+
+  dataLogReady = logStorage.begin(DATALOG_SD_CS_PIN, DATALOG_FILE) && dataLog.mount();
+  Serial.print("Data log: ");
+  if (dataLogReady)
+  {
+    Serial.print(dataLog.getBlockCount());
+    Serial.println(" blocks");
+  }
+  else
+  {
+    Serial.println("no SD card");
+  }
+}
+
+// Valve transitions are logged on every sweep, readings every DATALOG_INTERVAL
+void logSweep(bool logReadings)
+{
+  DeviceSweep devices = deviceManager.getLastSweep();
+  uint32_t now = rtc.getEpoch();
+  bool written = true;
+
+  for (uint8_t i = 0; i < devices.size; i++)
+  {
+    if (!devices.valid[i])
+      continue;
+
+    const DeviceStatusFrame &frame = devices.frames[i];
+    bool valveChanged = loggedValveOpen[i] != (bool)frame.valveOpen;
+    if (!logReadings && !valveChanged)
+      continue;
+
+    LogRecord record;
+    record.timestamp = now;
+    record.type = valveChanged ? LOG_VALVE_EVENT : LOG_READING;
+    record.address = devices.addresses[i];
+    record.valveOpen = frame.valveOpen;
+    record.status = frame.status;
+    record.moisture = frame.moisture;
+    record.errorCount = frame.errorCount;
+    record.flowPulses = frame.flowPulses;
+    loggedValveOpen[i] = frame.valveOpen;
+    if (dataLog.append(record) != LOG_APPENDED)
+      written = false;
+  }
+
+  // Card pulled, full or failing: keep serving what is on the card and retry
+  // the buffered block on later sweeps
+  if (!dataLog.sync(now))
+    written = false;
+
+  if (!written && !dataLogFailing)
+  {
+    Serial.println("Data log write failed, retrying");
+    dataLogFailing = true;
+  }
+  else if (written && dataLogFailing)
+  {
+    Serial.print("Data log writes recovered (");
+    Serial.print(dataLog.getDroppedRecords());
+    Serial.println(" records dropped)");
+    dataLogFailing = false;
+  }
+}
+
+void exportTelemetry()
+{
+  DeviceSweep devices = deviceManager.getLastSweep();
+  telemetry.exportReadings(rtc.getEpoch(), temperature, humidity,
+                           devices.addresses, devices.frames, devices.valid, devices.size);
 }
 
 void loop()
@@ -66,6 +166,33 @@ void loop()
   temperature = dht.readTemperature();
   humidity = dht.readHumidity();
 
+  if (millis() - previousSweepMillis >= SWEEP_INTERVAL)
+  {
+    previousSweepMillis = millis();
+    deviceManager.sweepDevices();
+
+    if (dataLogReady)
+    {
+      bool logReadings = millis() - previousLogMillis >= DATALOG_INTERVAL;
+      if (logReadings)
+        previousLogMillis = millis();
+      logSweep(logReadings);
+    }
+  }
+  events.poll(deviceManager);
+
+  if (TELEMETRY_INTERVAL > 0 && millis() - previousTelemetryMillis >= TELEMETRY_INTERVAL)
+  {
+    previousTelemetryMillis = millis();
+    exportTelemetry();
+  }
+
+  if (millis() - previousMemoryMillis >= MEMORY_SAMPLE_INTERVAL)
+  {
+    previousMemoryMillis = millis();
+    sampleMemory();
+  }
+
   client = server.available();
-  printWeb(client, deviceManager);
+  printWeb(client, deviceManager, events, dataLogReady ? &dataLog : NULL);
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+// Fleet simulator: runs the real DeviceManagement library against N virtual
+// children on a simulated I2C bus and reports how discovery, sweeps and
+// command latency scale with the number of zones.
+//
+//   pio run -e fleetSim -t exec
+//   .pio/build/fleetSim/program --clock 400000 --zones 10,50,100 --duration 120
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "config.h"
+#include "DeviceManagement.h"
+#include "StatusJson.h"
+#include "Simulation.h"
+#include "VirtualChild.h"
+
+#define MAX_ZONES 111 // Assignable 7-bit addresses from 0x08 to 0x77, minus 0x60
+
+struct Options
+{
+  uint32_t clockHz;
+  std::vector<int> zones;
+  double durationSeconds;
+  double commandRate; // Commands per second from the web UI, Poisson arrivals
+  uint32_t loopUs;    // Rest of main-parent loop(): mDNS, DHT, server.available()
+  uint32_t seed;
+  bool verbose;
+};
+
+struct Result
+{
+  int zones;
+  int discovered;
+  int bootAddresses; // Distinct addresses after a simultaneous cold boot
+  double discoveryMs;
+  double firstSweepMs;
+  double sweepMs;
+  uint32_t sweepBytes;
+  uint32_t sweepTransactions;
+  int validFrames;
+  uint32_t commands;
+  double latencyMs[4]; // p50, p95, p99, max
+  double busUtilisation;
+  double stretchShare; // Fraction of bus time spent clock stretching
+  uint32_t collisions;
+  uint32_t statusJsonBytes;
+};
+
+std::vector<VirtualChild *> populate(int zones, uint32_t seed, bool assigned)
+{
+  std::vector<VirtualChild *> children;
+  uint8_t address = BASE_ASSIGNED_ADDRESS;
+  for (int i = 0; i < zones; i++)
+  {
+    if (address == CRYPTO_CHIP_ADDRESS)
+      address++;
+    children.push_back(new VirtualChild(assigned ? address++ : 0x00, seed * 7919 + i + 1));
+    simulation.attach(children.back());
+  }
+  return children;
+}
+
+double percentile(std::vector<uint64_t> &samples, double fraction)
+{
+  if (samples.empty())
+    return 0;
+  std::sort(samples.begin(), samples.end());
+  size_t rank = (size_t)ceil(fraction * samples.size());
+  return samples[rank > 0 ? rank - 1 : 0] / (double)NS_PER_MS;
+}
+
+// Built by the same code as /api/status; the environment values only need plausible lengths
+uint32_t statusJsonBytes(const DeviceSweep &sweep)
+{
+  JsonDocument doc;
+  buildStatusJson(doc, sweep, 21.5, 48.25);
+  return measureJson(doc);
+}
+
+void runFleet(const Options &options, int zones, Result &result)
+{
+  simulation.reset(options.clockHz);
+  simulation.verbose = options.verbose;
+  simulation.addFixedDevice(CRYPTO_CHIP_ADDRESS);
+  populate(zones, options.seed, true);
+
+  DeviceManagement deviceManager;
+
+  uint64_t start = simulation.time();
+  deviceManager.discoverDevices();
+  result.discoveryMs = (simulation.time() - start) / (double)NS_PER_MS;
+  DeviceBuffer devices = deviceManager.getConnectedDevices();
+  result.discovered = devices.size;
+  std::vector<uint8_t> addresses(devices.data, devices.data + devices.size);
+  delete[] devices.data;
+
+  // First sweep writes the bulk status selector to every child
+  start = simulation.time();
+  deviceManager.sweepDevices();
+  result.firstSweepMs = (simulation.time() - start) / (double)NS_PER_MS;
+
+  BusStats before = simulation.stats;
+  start = simulation.time();
+  DeviceSweep sweep = deviceManager.sweepDevices();
+  result.sweepMs = (simulation.time() - start) / (double)NS_PER_MS;
+  result.sweepBytes = simulation.stats.bytes - before.bytes;
+  result.sweepTransactions = simulation.stats.transactions - before.transactions;
+  result.validFrames = 0;
+  for (size_t i = 0; i < sweep.size; i++)
+    result.validFrames += sweep.valid[i];
+
+  // Steady-state operation: main-parent loop() with periodic sweeps while
+  // web clients send commands that wait for the loop to get to them
+  struct Command
+  {
+    uint64_t arrival;
+    uint8_t address;
+    DeviceAction action;
+  };
+  std::deque<Command> pending;
+  std::vector<uint64_t> latencies;
+  srand(options.seed + zones);
+
+  std::function<void()> arrive = [&]() {
+    if (!addresses.empty())
+    {
+      uint8_t address = addresses[rand() % addresses.size()];
+      pending.push_back({simulation.time(), address, rand() % 2 ? DEVICE_ACTIVATE : DEVICE_DEACTIVATE});
+    }
+    double gap = -log(1.0 - rand() / (RAND_MAX + 1.0)) / options.commandRate;
+    simulation.schedule((uint64_t)(gap * 1e9), arrive);
+  };
+  if (options.commandRate > 0)
+    simulation.schedule(0, arrive);
+
+  before = simulation.stats;
+  start = simulation.time();
+  uint64_t end = start + (uint64_t)(options.durationSeconds * 1e9);
+  uint64_t previousSweep = start;
+  while (simulation.time() < end)
+  {
+    simulation.advance(options.loopUs * NS_PER_US);
+
+    if (simulation.time() - previousSweep >= SWEEP_INTERVAL * NS_PER_MS)
+    {
+      previousSweep = simulation.time();
+      sweep = deviceManager.sweepDevices();
+    }
+
+    // printWeb() serves one client per loop iteration
+    if (!pending.empty())
+    {
+      Command command = pending.front();
+      pending.pop_front();
+      deviceManager.sendDeviceCommand(command.address, command.action);
+      deviceManager.refreshDevice(command.address); // As handleCommand() in Web.cpp
+      latencies.push_back(simulation.time() - command.arrival);
+    }
+  }
+
+  uint64_t elapsed = simulation.time() - start;
+  uint64_t busy = simulation.stats.busyNs - before.busyNs;
+  result.commands = latencies.size();
+  result.latencyMs[0] = percentile(latencies, 0.50);
+  result.latencyMs[1] = percentile(latencies, 0.95);
+  result.latencyMs[2] = percentile(latencies, 0.99);
+  result.latencyMs[3] = percentile(latencies, 1.0);
+  result.busUtilisation = (double)busy / elapsed;
+  result.stretchShare = busy ? (double)(simulation.stats.stretchNs - before.stretchNs) / busy : 0;
+  result.collisions = simulation.stats.collisions;
+  result.statusJsonBytes = statusJsonBytes(sweep);
+}
+
+// All children power up together at the default address and run setup()
+void runColdBoot(const Options &options, int zones, Result &result)
+{
+  simulation.reset(options.clockHz);
+  simulation.verbose = options.verbose;
+  simulation.addFixedDevice(CRYPTO_CHIP_ADDRESS);
+  std::vector<VirtualChild *> children = populate(zones, options.seed, false);
+
+  DeviceManagement deviceManager;
+  deviceManager.setup();
+
+  std::vector<uint8_t> assigned;
+  for (VirtualChild *child : children)
+  {
+    if (std::find(assigned.begin(), assigned.end(), child->getAddress()) == assigned.end())
+      assigned.push_back(child->getAddress());
+  }
+  result.bootAddresses = assigned.size();
+}
+
+// DeviceManagement keeps its state in globals, so every scenario gets a fresh process
+template <typename Scenario>
+bool isolate(Scenario scenario, Result &result)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+    return false;
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    close(fds[0]);
+    scenario(result);
+    ssize_t written = ::write(fds[1], &result, sizeof(result));
+    _exit(written == sizeof(result) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  bool ok = read(fds[0], &result, sizeof(result)) == sizeof(result);
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void printReport(const Options &options, const std::vector<Result> &results)
+{
+  printf("Fleet simulation: I2C %u kHz, %.0f s per fleet, %.2f commands/s, sweep every %d ms, loop overhead %u us\n\n",
+         options.clockHz / 1000, options.durationSeconds, options.commandRate, SWEEP_INTERVAL, options.loopUs);
+  printf("| zones | found | discovery ms | sweep ms (first / steady) | bytes / txns per sweep | "
+         "cmd latency ms p50 / p95 / p99 / max | bus util | stretch | /api/status bytes | cold boot addrs |\n");
+  printf("|------:|------:|-------------:|--------------------------:|-----------------------:|"
+         "--------------------------------------:|---------:|--------:|------------------:|----------------:|\n");
+
+  for (const Result &r : results)
+  {
+    printf("| %5d | %5d | %12.1f | %11.2f / %-11.2f | %10u / %-9u | %7.2f / %7.2f / %7.2f / %7.2f | %7.2f%% | %6.1f%% | %10u%-7s | %15d |\n",
+           r.zones, r.discovered, r.discoveryMs, r.firstSweepMs, r.sweepMs, r.sweepBytes, r.sweepTransactions,
+           r.latencyMs[0], r.latencyMs[1], r.latencyMs[2], r.latencyMs[3], r.busUtilisation * 100,
+           r.stretchShare * 100, r.statusJsonBytes, r.statusJsonBytes >= JSON_BUFFER_SIZE ? " (over)" : "",
+           r.bootAddresses);
+  }
+
+  printf("\nNotes\n");
+  for (const Result &r : results)
+  {
+    if (r.discovered < r.zones)
+      printf("- %d zones: only %d tracked; MAX_DEVICES is %d for this build\n", r.zones, r.discovered, MAX_DEVICES);
+    if (r.validFrames < r.discovered)
+      printf("- %d zones: %d of %d status frames failed validation\n", r.zones, r.discovered - r.validFrames, r.discovered);
+    if (r.statusJsonBytes >= JSON_BUFFER_SIZE)
+      printf("- %d zones: /api/status needs %u bytes, JSON_BUFFER_SIZE is %d\n", r.zones, r.statusJsonBytes, JSON_BUFFER_SIZE);
+    if (r.zones > 1 && r.bootAddresses < r.zones)
+      printf("- %d zones: simultaneous cold boot assigns %d address(es) to %d children "
+             "(all unassigned children answer the default address together)\n",
+             r.zones, r.bootAddresses, r.zones);
+    if (r.collisions > 0)
+      printf("- %d zones: %u read(s) with several children driving the bus\n", r.zones, r.collisions);
+  }
+}
+
+std::vector<int> parseZones(const char *text)
+{
+  std::vector<int> zones;
+  while (*text)
+  {
+    int value = atoi(text);
+    if (value > 0)
+      zones.push_back(value > MAX_ZONES ? MAX_ZONES : value);
+    const char *comma = strchr(text, ',');
+    if (comma == NULL)
+      break;
+    text = comma + 1;
+  }
+  return zones;
+}
+
+int main(int argc, char **argv)
+{
+  Options options = {100000, parseZones("1,5,10,25,50,100"), 600, 0.5, 500, 1, false};
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--clock") == 0 && hasValue)
+      options.clockHz = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--zones") == 0 && hasValue)
+      options.zones = parseZones(argv[++i]);
+    else if (strcmp(argv[i], "--duration") == 0 && hasValue)
+      options.durationSeconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--command-rate") == 0 && hasValue)
+      options.commandRate = atof(argv[++i]);
+    else if (strcmp(argv[i], "--loop-us") == 0 && hasValue)
+      options.loopUs = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+      options.seed = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--verbose") == 0)
+      options.verbose = true;
+    else
+    {
+      fprintf(stderr,
+              "usage: %s [--clock HZ] [--zones N,N,...] [--duration SECONDS] [--command-rate PER_SECOND]\n"
+              "          [--loop-us MICROSECONDS] [--seed N] [--verbose]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (options.clockHz == 0 || options.zones.empty())
+  {
+    fprintf(stderr, "clock and zones must be non-zero\n");
+    return 1;
+  }
+
+  std::vector<Result> results;
+  for (int zones : options.zones)
+  {
+    Result result;
+    memset(&result, 0, sizeof(result));
+    if (!isolate([&](Result &r) { runFleet(options, zones, r); }, result) ||
+        !isolate([&](Result &r) { runColdBoot(options, zones, r); }, result))
+    {
+      fprintf(stderr, "simulation of %d zones failed\n", zones);
+      return 1;
+    }
+    result.zones = zones;
+    results.push_back(result);
+  }
+
+  printReport(options, results);
+  return 0;
+}
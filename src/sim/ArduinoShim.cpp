@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdio.h>
+#include "Simulation.h"
+
+SimSerial Serial;
+TwoWire Wire;
+
+unsigned long millis()
+{
+  return simulation.time() / NS_PER_MS;
+}
+
+unsigned long micros()
+{
+  return simulation.time() / NS_PER_US;
+}
+
+void delay(unsigned long ms)
+{
+  simulation.advance(ms * NS_PER_MS);
+}
+
+size_t Print::print(const char *text)
+{
+  size_t count = 0;
+  while (*text)
+    count += write((uint8_t)*text++);
+  return count;
+}
+
+size_t Print::print(long value, int base)
+{
+  if (value < 0)
+    return print('-') + print((unsigned long)-value, base);
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return print(text);
+}
+
+size_t SimSerial::write(uint8_t c)
+{
+  if (simulation.verbose)
+    putchar(c);
+  return 1;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  txAddress = address;
+  txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool stopBit)
+{
+  (void)stopBit;
+  return simulation.write(txAddress, txBuffer, txLength);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+  if (quantity > WIRE_BUFFER_SIZE)
+    quantity = WIRE_BUFFER_SIZE;
+
+  rxIndex = 0;
+  rxLength = simulation.read(address, rxBuffer, quantity);
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if (txLength >= WIRE_BUFFER_SIZE)
+    return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+int TwoWire::available()
+{
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read()
+{
+  return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
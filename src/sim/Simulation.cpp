@@ -0,0 +1,153 @@
+#include "Simulation.h"
+#include <string.h>
+#include "VirtualChild.h"
+
+Simulation simulation;
+
+Simulation::Simulation() : verbose(false)
+{
+  reset(100000);
+}
+
+void Simulation::reset(uint32_t clockHz)
+{
+  events = std::priority_queue<Event, std::vector<Event>, std::greater<Event>>();
+  children.clear();
+  memset(fixedDevices, 0, sizeof(fixedDevices));
+  memset(&stats, 0, sizeof(stats));
+  now = 0;
+  order = 0;
+  bitNs = 1000000000ULL / clockHz;
+}
+
+void Simulation::schedule(uint64_t delayNs, std::function<void()> action)
+{
+  events.push({now + delayNs, order++, action});
+}
+
+void Simulation::advance(uint64_t durationNs)
+{
+  uint64_t target = now + durationNs;
+  while (!events.empty() && events.top().time <= target)
+  {
+    Event event = events.top();
+    events.pop();
+    now = event.time;
+    event.action();
+  }
+  now = target;
+}
+
+void Simulation::attach(VirtualChild *child)
+{
+  children.push_back(child);
+  child->boot();
+}
+
+void Simulation::addFixedDevice(uint8_t address)
+{
+  fixedDevices[address] = true;
+}
+
+std::vector<VirtualChild *> Simulation::childrenAt(uint8_t address)
+{
+  std::vector<VirtualChild *> targets;
+  for (VirtualChild *child : children)
+  {
+    if (child->getAddress() == address)
+      targets.push_back(child);
+  }
+  return targets;
+}
+
+// START plus address byte, stretched until every addressed child's TWI ISR
+// can run (it cannot while an earlier callback is still executing)
+uint64_t Simulation::addressPhase(const std::vector<VirtualChild *> &targets)
+{
+  uint64_t stretch = 0;
+  for (VirtualChild *child : targets)
+  {
+    uint64_t wait = child->getBusyUntil() > now ? child->getBusyUntil() - now : 0;
+    if (wait + CHILD_ISR_BYTE_NS > stretch)
+      stretch = wait + CHILD_ISR_BYTE_NS;
+  }
+
+  stats.stretchNs += stretch;
+  return bitNs + 9 * bitNs + stretch;
+}
+
+void Simulation::occupy(uint64_t durationNs, uint32_t bytes)
+{
+  stats.transactions++;
+  stats.bytes += bytes;
+  stats.busyNs += durationNs;
+  advance(durationNs);
+}
+
+uint8_t Simulation::write(uint8_t address, const uint8_t *data, uint8_t length)
+{
+  std::vector<VirtualChild *> targets = childrenAt(address);
+  if (targets.empty() && !fixedDevices[address])
+  {
+    stats.nacks++;
+    occupy(11 * bitNs, 1); // START, address, NACK, STOP
+    return 2;
+  }
+
+  uint64_t duration = addressPhase(targets);
+  uint64_t perByte = 9 * bitNs + (targets.empty() ? 0 : CHILD_ISR_BYTE_NS);
+  duration += length * perByte + bitNs;
+  if (!targets.empty())
+    stats.stretchNs += length * CHILD_ISR_BYTE_NS;
+  occupy(duration, 1 + length);
+
+  // onReceive runs from the STOP interrupt, after the bus is released
+  for (VirtualChild *child : targets)
+    child->receive(data, length);
+  return 0;
+}
+
+uint8_t Simulation::read(uint8_t address, uint8_t *buffer, uint8_t length)
+{
+  std::vector<VirtualChild *> targets = childrenAt(address);
+  if (targets.empty())
+  {
+    stats.nacks++;
+    occupy(11 * bitNs, 1);
+    return 0;
+  }
+
+  uint64_t duration = addressPhase(targets);
+
+  // onRequest runs inside the address-match ISR, so SCL stays low for all of it.
+  // Children sharing an address drive SDA together: the bus is a wired AND,
+  // and bytes nobody drives read as 0xFF.
+  memset(buffer, 0xFF, length);
+  uint64_t callback = 0;
+  bool first = true;
+  bool collided = false;
+  for (VirtualChild *child : targets)
+  {
+    uint8_t response[CHILD_BUFFER_SIZE];
+    uint64_t cost = 0;
+    uint8_t count = child->request(response, cost);
+    if (cost > callback)
+      callback = cost;
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+      uint8_t value = i < count ? response[i] : 0xFF;
+      if (!first && buffer[i] != value)
+        collided = true;
+      buffer[i] &= value;
+    }
+    first = false;
+  }
+  if (collided)
+    stats.collisions++;
+
+  stats.stretchNs += callback + length * CHILD_ISR_BYTE_NS;
+  duration += callback + length * (9 * bitNs + CHILD_ISR_BYTE_NS) + bitNs;
+  occupy(duration, 1 + length);
+  return length;
+}
@@ -0,0 +1,78 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+class VirtualChild;
+
+#define NS_PER_US 1000ULL
+#define NS_PER_MS 1000000ULL
+
+// Per-byte TWI interrupt on a 16 MHz ATmega328: SCL is held low until it runs
+#define CHILD_ISR_BYTE_NS (4 * NS_PER_US)
+
+struct BusStats
+{
+  uint64_t busyNs;    // SCL/SDA in use, including clock stretching
+  uint64_t stretchNs; // Part of busyNs spent waiting on child ISRs
+  uint32_t transactions;
+  uint32_t bytes; // Address and data bytes on the wire
+  uint32_t nacks;
+  uint32_t collisions; // Reads where several children drove different data
+};
+
+// Discrete-event model of the parent's I2C bus. The parent code runs as the
+// only process and blocks on the bus; child-side work (loop() sampling,
+// ISR callbacks still running) is scheduled on the event queue.
+class Simulation
+{
+private:
+  struct Event
+  {
+    uint64_t time;
+    uint64_t order; // Keeps same-time events in scheduling order
+    std::function<void()> action;
+
+    bool operator>(const Event &other) const
+    {
+      return time != other.time ? time > other.time : order > other.order;
+    }
+  };
+
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::vector<VirtualChild *> children;
+  bool fixedDevices[128]; // Non-child devices that only ACK, like the ATECC508A
+  uint64_t now;
+  uint64_t order;
+  uint64_t bitNs;
+
+  std::vector<VirtualChild *> childrenAt(uint8_t address);
+  uint64_t addressPhase(const std::vector<VirtualChild *> &targets);
+  void occupy(uint64_t durationNs, uint32_t bytes);
+
+public:
+  BusStats stats;
+  bool verbose;
+
+  Simulation();
+  void reset(uint32_t clockHz);
+  uint64_t time() const { return now; }
+  void schedule(uint64_t delayNs, std::function<void()> action);
+  // Moves time forward, running every event that falls due on the way
+  void advance(uint64_t durationNs);
+
+  void attach(VirtualChild *child);
+  void addFixedDevice(uint8_t address);
+
+  // Master write; returns the Wire endTransmission() code
+  uint8_t write(uint8_t address, const uint8_t *data, uint8_t length);
+  // Master read of exactly length bytes; returns 0 if the address was not acknowledged
+  uint8_t read(uint8_t address, uint8_t *buffer, uint8_t length);
+};
+
+extern Simulation simulation;
+
+#endif
@@ -0,0 +1,239 @@
+#include "VirtualChild.h"
+#include <stdio.h>
+#include <string.h>
+#include "frames.h"
+#include "Simulation.h"
+
+// Costs on a 16 MHz ATmega328, measured in cycles of the equivalent code paths
+#define SERIAL_CHAR_NS (3 * NS_PER_US)            // Copy into the TX ring buffer
+#define SERIAL_BLOCKED_CHAR_NS (87 * NS_PER_US)   // One character time at 115200 baud
+#define SERIAL_TX_BUFFER 64
+#define JSON_SERIALIZE_NS (250 * NS_PER_US)       // serializeJson of {"moisture":N}
+#define STATUS_FRAME_NS (25 * NS_PER_US)          // sendStatusFrame
+#define WIRE_RESTART_NS (150 * NS_PER_US)         // Wire.end() + Wire.begin(address)
+#define MOISTURE_INTERVAL_NS (1000 * NS_PER_MS)   // moistureInterval in main-child.cpp
+#define FLOW_PULSES_PER_SECOND 7
+
+VirtualChild::VirtualChild(uint8_t address, uint32_t seed)
+    : address(address), randomState(seed ? seed : 1)
+{
+}
+
+uint32_t VirtualChild::nextRandom()
+{
+  // xorshift32, deterministic per child
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void VirtualChild::boot()
+{
+  currentStatus = address == 0 ? STATUS_UNINITIALIZED : STATUS_STANDBY;
+  currentAction = DEVICE_SLEEP;
+  valveActive = false;
+  identifyMode = false;
+  moistureValue = 300 + nextRandom() % 400;
+  flowPulses = 0;
+  valveOpenedAt = 0;
+  lastCommandResult = COMMAND_NONE;
+  errorCount = 0;
+  busyUntil = 0;
+  bootTime = simulation.time();
+  serialQueued = 0;
+  serialDrainedAt = simulation.time();
+
+  // Children power up at slightly different moments
+  simulation.schedule(nextRandom() % MOISTURE_INTERVAL_NS, [this]() { sampleMoisture(); });
+}
+
+void VirtualChild::sampleMoisture()
+{
+  int step = (int)(nextRandom() % 7) - 3;
+  if (valveActive)
+    step += 4;
+  int value = moistureValue + step;
+  moistureValue = value < 0 ? 0 : (value > 1023 ? 1023 : value);
+
+  simulation.schedule(MOISTURE_INTERVAL_NS, [this]() { sampleMoisture(); });
+}
+
+uint64_t VirtualChild::serialPrint(uint32_t characters)
+{
+  uint64_t now = simulation.time();
+  uint32_t drained = (now - serialDrainedAt) / SERIAL_BLOCKED_CHAR_NS;
+  serialQueued = drained >= serialQueued ? 0 : serialQueued - drained;
+  serialDrainedAt = now;
+
+  uint32_t room = SERIAL_TX_BUFFER - serialQueued;
+  if (characters <= room)
+  {
+    serialQueued += characters;
+    return characters * SERIAL_CHAR_NS;
+  }
+
+  // Buffer full inside an ISR: HardwareSerial polls the UART for every extra character
+  serialQueued = SERIAL_TX_BUFFER;
+  return room * SERIAL_CHAR_NS + (characters - room) * SERIAL_BLOCKED_CHAR_NS;
+}
+
+uint32_t VirtualChild::currentFlowPulses()
+{
+  if (!valveActive)
+    return flowPulses;
+  return flowPulses + (simulation.time() - valveOpenedAt) * FLOW_PULSES_PER_SECOND / 1000000000ULL;
+}
+
+// loop() picks up status changes within one iteration; treated as immediate
+void VirtualChild::updateValve()
+{
+  if (currentStatus == STATUS_ACTIVE && !valveActive)
+  {
+    valveActive = true;
+    valveOpenedAt = simulation.time();
+  }
+  else if (currentStatus == STATUS_STANDBY && valveActive)
+  {
+    flowPulses = currentFlowPulses();
+    valveActive = false;
+  }
+}
+
+static uint8_t textResponse(uint8_t *response, const char *text)
+{
+  uint8_t length = strlen(text);
+  response[0] = length;
+  memcpy(response + 1, text, length);
+  return length + 1;
+}
+
+// Mirrors handleAction() in main-child.cpp, including its Serial.println calls
+uint64_t VirtualChild::handleAction(DeviceAction action, uint8_t *response, uint8_t &length)
+{
+  uint64_t cost = 0;
+  switch (action)
+  {
+  case DEVICE_STATUS:
+  {
+    cost += serialPrint(sizeof("Sending STATUS response") + 1);
+    char json[32];
+    snprintf(json, sizeof(json), "{\"moisture\":%u}", moistureValue);
+    length = textResponse(response, json);
+    cost += JSON_SERIALIZE_NS;
+    break;
+  }
+  case DEVICE_BULK_STATUS:
+  {
+    DeviceStatusFrame frame;
+    frame.status = currentStatus;
+    frame.moisture = moistureValue;
+    frame.valveOpen = valveActive;
+    frame.uptimeSeconds = (simulation.time() - bootTime) / 1000000000ULL;
+    frame.flowPulses = currentFlowPulses();
+    frame.lastCommandResult = lastCommandResult;
+    frame.errorCount = errorCount;
+    sealFrame(frame);
+    memcpy(response, &frame, sizeof(frame));
+    length = sizeof(frame);
+    cost += STATUS_FRAME_NS;
+    break;
+  }
+  case DEVICE_DIAGNOSTICS:
+  {
+    // The host has no AVR memory layout, so the cached report is all zeros
+    DeviceMemoryFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    sealFrame(frame);
+    memcpy(response, &frame, sizeof(frame));
+    length = sizeof(frame);
+    cost += STATUS_FRAME_NS;
+    break;
+  }
+  case DEVICE_ACTIVATE:
+    cost += serialPrint(sizeof("Starting irrigation (simulated)") + 1);
+    length = textResponse(response, "Irrigation started");
+    currentStatus = STATUS_ACTIVE;
+    break;
+  case DEVICE_DEACTIVATE:
+    cost += serialPrint(sizeof("Stopping irrigation (simulated)") + 1);
+    length = textResponse(response, "Irrigation stopped");
+    currentStatus = STATUS_STANDBY;
+    break;
+  case DEVICE_IDENTIFY:
+    cost += serialPrint(sizeof("Entering identify mode (simulated)") + 1);
+    identifyMode = true;
+    length = textResponse(response, "Identifying");
+    break;
+  case DEVICE_SLEEP:
+    cost += serialPrint(sizeof("Entering sleep mode (simulated)") + 1);
+    identifyMode = false;
+    currentStatus = STATUS_STANDBY;
+    length = textResponse(response, "Sleeping");
+    break;
+  default:
+    cost += serialPrint(sizeof("Unknown action received") + 1);
+    length = textResponse(response, "Unknown action");
+    break;
+  }
+
+  updateValve();
+  return cost;
+}
+
+void VirtualChild::receive(const uint8_t *data, uint8_t length)
+{
+  if (length < 1)
+    return;
+
+  uint64_t cost = 0;
+  currentAction = (DeviceAction)data[0];
+
+  if (currentAction > DEVICE_DIAGNOSTICS)
+  {
+    lastCommandResult = COMMAND_UNKNOWN;
+    errorCount++;
+  }
+  else if (currentAction >= DEVICE_ACTIVATE && currentAction <= DEVICE_SLEEP)
+  {
+    lastCommandResult = COMMAND_OK;
+  }
+
+  if (currentAction == DEVICE_ASSIGN_ADDRESS)
+  {
+    if (length < 2)
+    {
+      lastCommandResult = COMMAND_MALFORMED;
+      errorCount++;
+      return;
+    }
+
+    address = data[1];
+    cost += serialPrint(sizeof("Address assigned: 0x") + 3);
+    cost += WIRE_RESTART_NS;
+    currentStatus = STATUS_STANDBY;
+  }
+  else
+  {
+    // The response is discarded in receive context, but the work still runs
+    uint8_t response[CHILD_BUFFER_SIZE];
+    uint8_t responseLength = 0;
+    cost += handleAction(currentAction, response, responseLength);
+  }
+
+  busyUntil = simulation.time() + cost;
+}
+
+uint8_t VirtualChild::request(uint8_t *response, uint64_t &costNs)
+{
+  if (currentStatus == STATUS_UNINITIALIZED)
+  {
+    response[0] = STATUS_UNINITIALIZED;
+    costNs = 0;
+    return 1;
+  }
+
+  uint8_t length = 0;
+  costNs = handleAction(currentAction, response, length);
+  return length;
+}
@@ -0,0 +1,53 @@
+#ifndef VIRTUAL_CHILD_H
+#define VIRTUAL_CHILD_H
+
+#include <stdint.h>
+#include "enums.h"
+
+#define CHILD_BUFFER_SIZE 32 // AVR Wire transmit buffer
+
+// Behavioural model of src/main-child.cpp on a 16 MHz Nano: the same
+// receiveEvent/requestEvent state machine, with the time each callback
+// keeps the TWI interrupt busy. Serial output from inside the callbacks is
+// modelled too, since a full TX buffer makes print() spin with interrupts off.
+class VirtualChild
+{
+private:
+  uint8_t address;
+  DeviceStatus currentStatus;
+  DeviceAction currentAction;
+  bool valveActive;
+  bool identifyMode;
+  uint16_t moistureValue;
+  uint32_t flowPulses;
+  uint64_t valveOpenedAt;
+  uint8_t lastCommandResult;
+  uint16_t errorCount;
+  uint64_t busyUntil;
+  uint64_t bootTime;
+  uint32_t randomState;
+
+  // Serial TX ring buffer fill level, drained at the configured baud rate
+  uint32_t serialQueued;
+  uint64_t serialDrainedAt;
+
+  uint32_t nextRandom();
+  uint64_t serialPrint(uint32_t characters);
+  uint64_t handleAction(DeviceAction action, uint8_t *response, uint8_t &length);
+  void sampleMoisture();
+  void updateValve();
+  uint32_t currentFlowPulses();
+
+public:
+  VirtualChild(uint8_t address, uint32_t seed);
+  void boot();
+  // receiveEvent(): called when a master write ends
+  void receive(const uint8_t *data, uint8_t length);
+  // requestEvent(): fills response, returns its length and the callback time
+  uint8_t request(uint8_t *response, uint64_t &costNs);
+
+  uint8_t getAddress() const { return address; }
+  uint64_t getBusyUntil() const { return busyUntil; }
+};
+
+#endif
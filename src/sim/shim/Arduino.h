@@ -0,0 +1,72 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Just enough of the Arduino API to build the parent libraries on the host
+// against the fleet simulator. Time only moves when the simulation says so.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+class String
+{
+private:
+  std::string text;
+
+public:
+  String(const char *value = "") : text(value) {}
+  String &operator+=(char c)
+  {
+    text += c;
+    return *this;
+  }
+  unsigned int length() const { return text.size(); }
+  const char *c_str() const { return text.c_str(); }
+};
+
+class Print
+{
+public:
+  virtual size_t write(uint8_t c) = 0;
+  size_t print(const char *text);
+  size_t print(const String &text) { return print(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+// Discards output unless the simulation runs verbose
+class SimSerial : public Print
+{
+public:
+  size_t write(uint8_t c);
+};
+
+extern SimSerial Serial;
+
+#endif
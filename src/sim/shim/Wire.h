@@ -0,0 +1,32 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+#define WIRE_BUFFER_SIZE 32
+
+// Master side of Wire, routed onto the simulated bus with SAMD semantics:
+// requestFrom() reads the full quantity once the address is acknowledged.
+class TwoWire : public Stream
+{
+private:
+  uint8_t txAddress;
+  uint8_t txBuffer[WIRE_BUFFER_SIZE];
+  uint8_t txLength;
+  uint8_t rxBuffer[WIRE_BUFFER_SIZE];
+  uint8_t rxLength;
+  uint8_t rxIndex;
+
+public:
+  void begin() {}
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool stopBit = true);
+  uint8_t requestFrom(int address, int quantity);
+  size_t write(uint8_t data);
+  int available();
+  int read();
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,313 @@
+// Data log append, range queries and recovery on a host file: pio test -e native
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "DataLog.h"
+
+#define LOG_FILE "datalog-test.bin"
+#define LOG_RECORDS 20000
+#define LOG_ZONES 20
+#define LOG_START 1700000000UL
+#define LOG_STEP 10 // Seconds between records
+
+// Stands in for SdLogStorage on the host
+class FileLogStorage : public LogStorage
+{
+private:
+  FILE *file;
+
+public:
+  FileLogStorage(const char *path)
+  {
+    file = fopen(path, "r+b");
+    if (file == NULL)
+      file = fopen(path, "w+b");
+  }
+
+  ~FileLogStorage()
+  {
+    if (file)
+      fclose(file);
+  }
+
+  uint32_t size()
+  {
+    fseek(file, 0, SEEK_END);
+    return ftell(file);
+  }
+
+  bool read(uint32_t offset, uint8_t *buffer, size_t length)
+  {
+    return fseek(file, offset, SEEK_SET) == 0 && fread(buffer, 1, length, file) == length;
+  }
+
+  bool write(uint32_t offset, const uint8_t *buffer, size_t length)
+  {
+    return fseek(file, offset, SEEK_SET) == 0 && fwrite(buffer, 1, length, file) == length;
+  }
+
+  bool flush()
+  {
+    return fflush(file) == 0;
+  }
+};
+
+// RAM-backed storage whose reads can be made to fail, as a flaky SD card does
+class MemoryLogStorage : public LogStorage
+{
+private:
+  uint8_t data[64 * DATALOG_BLOCK_SIZE];
+  uint32_t length;
+
+public:
+  bool failReads;
+
+  MemoryLogStorage() : length(0), failReads(false) {}
+
+  uint32_t size() { return length; }
+
+  bool read(uint32_t offset, uint8_t *buffer, size_t count)
+  {
+    if (failReads || offset + count > length)
+      return false;
+    memcpy(buffer, data + offset, count);
+    return true;
+  }
+
+  bool write(uint32_t offset, const uint8_t *buffer, size_t count)
+  {
+    if (offset + count > sizeof(data))
+      return false;
+    memcpy(data + offset, buffer, count);
+    if (offset + count > length)
+      length = offset + count;
+    return true;
+  }
+
+  bool flush() { return true; }
+};
+
+// Fails every write while failing is set, as a pulled or full SD card does
+class FailingLogStorage : public LogStorage
+{
+public:
+  bool failing;
+
+  FailingLogStorage() : failing(true) {}
+
+  uint32_t size() { return 0; }
+
+  bool read(uint32_t offset, uint8_t *buffer, size_t length)
+  {
+    (void)offset;
+    (void)buffer;
+    (void)length;
+    return false;
+  }
+
+  bool write(uint32_t offset, const uint8_t *buffer, size_t length)
+  {
+    (void)offset;
+    (void)buffer;
+    (void)length;
+    return !failing;
+  }
+
+  bool flush() { return !failing; }
+};
+
+bool countRecord(const LogRecord &record, void *context)
+{
+  (void)record;
+  (*(uint32_t *)context)++;
+  return true;
+}
+
+// Accepts records until the budget in context runs out, like a client that disconnects
+bool takeRecords(const LogRecord &record, void *context)
+{
+  (void)record;
+  uint32_t &remaining = *(uint32_t *)context;
+  if (remaining == 0)
+    return false;
+  remaining--;
+  return true;
+}
+
+LogRecord makeRecord(uint32_t i)
+{
+  LogRecord record = {};
+  record.timestamp = LOG_START + i * LOG_STEP;
+  record.type = i % 50 == 0 ? LOG_VALVE_EVENT : LOG_READING;
+  record.address = 0x08 + i % LOG_ZONES;
+  record.moisture = i % 1024;
+  record.flowPulses = i;
+  return record;
+}
+
+// Synthetic history shared by the file-backed tests
+void writeHistory()
+{
+  remove(LOG_FILE);
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+  TEST_ASSERT_TRUE(dataLog.mount());
+  for (uint32_t i = 0; i < LOG_RECORDS; i++)
+    TEST_ASSERT_EQUAL(LOG_APPENDED, dataLog.append(makeRecord(i)));
+  TEST_ASSERT_TRUE(dataLog.flush());
+}
+
+const uint32_t expectedBlocks = (LOG_RECORDS + DATALOG_RECORDS_PER_BLOCK - 1) / DATALOG_RECORDS_PER_BLOCK;
+
+void setUp()
+{
+  writeHistory();
+}
+
+void tearDown()
+{
+  remove(LOG_FILE);
+}
+
+void test_remount_finds_every_block()
+{
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+  TEST_ASSERT_TRUE(dataLog.mount());
+  TEST_ASSERT_EQUAL_UINT32(expectedBlocks, dataLog.getBlockCount());
+}
+
+void test_range_queries_seek_through_the_index()
+{
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+  TEST_ASSERT_TRUE(dataLog.mount());
+
+  // Windows of various sizes across the history, including the edges
+  uint32_t windows[][2] = {{0, LOG_RECORDS - 1}, {0, 0}, {LOG_RECORDS / 2, LOG_RECORDS / 2 + 359},
+                           {LOG_RECORDS - 10, LOG_RECORDS - 1}, {1234, 1234 + 8639}};
+  for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+  {
+    uint32_t first = windows[w][0];
+    uint32_t last = windows[w][1];
+    uint32_t count = 0;
+    uint32_t before = dataLog.getBlocksRead();
+    uint32_t visited = dataLog.query(LOG_START + first * LOG_STEP, LOG_START + last * LOG_STEP, countRecord, &count);
+    uint32_t blocks = dataLog.getBlocksRead() - before;
+
+    TEST_ASSERT_EQUAL_UINT32(last - first + 1, visited);
+    TEST_ASSERT_EQUAL_UINT32(visited, count);
+    // Blocks holding the window plus a handful of header reads to find it
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(visited / DATALOG_RECORDS_PER_BLOCK + 2 + 2 * 8, blocks);
+  }
+}
+
+void test_visitor_can_end_a_query_early()
+{
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+  TEST_ASSERT_TRUE(dataLog.mount());
+
+  uint32_t remaining = 100;
+  uint32_t before = dataLog.getBlocksRead();
+  TEST_ASSERT_EQUAL_UINT32(100, dataLog.query(0, UINT32_MAX, takeRecords, &remaining));
+  // Only the blocks holding those records are read, not the whole log
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(100 / DATALOG_RECORDS_PER_BLOCK + 2 + 2 * 8, dataLog.getBlocksRead() - before);
+}
+
+void test_torn_last_block_is_dropped()
+{
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+
+  // Tear the last block as a power cut mid-write would
+  uint8_t garbage[100];
+  memset(garbage, 0xA5, sizeof(garbage));
+  storage.write((expectedBlocks - 1) * DATALOG_BLOCK_SIZE + 200, garbage, sizeof(garbage));
+  storage.flush();
+
+  TEST_ASSERT_TRUE(dataLog.mount());
+  TEST_ASSERT_EQUAL_UINT32(expectedBlocks - 1, dataLog.getBlockCount());
+}
+
+void test_damage_beyond_the_last_block_does_not_mount()
+{
+  FileLogStorage storage(LOG_FILE);
+  DataLog dataLog(storage);
+
+  // A power cut tears at most one block; two bad blocks mean something else is wrong
+  uint8_t garbage[100];
+  memset(garbage, 0xA5, sizeof(garbage));
+  storage.write((expectedBlocks - 1) * DATALOG_BLOCK_SIZE + 200, garbage, sizeof(garbage));
+  storage.write((expectedBlocks - 2) * DATALOG_BLOCK_SIZE + 200, garbage, sizeof(garbage));
+  storage.flush();
+
+  TEST_ASSERT_FALSE(dataLog.mount());
+}
+
+void test_unreadable_storage_does_not_mount()
+{
+  MemoryLogStorage storage;
+  {
+    DataLog dataLog(storage);
+    TEST_ASSERT_TRUE(dataLog.mount());
+    for (uint32_t i = 0; i < 1000; i++)
+      dataLog.append(makeRecord(i));
+    TEST_ASSERT_TRUE(dataLog.flush());
+  }
+
+  // Mounting must not mistake failed reads for torn blocks and truncate the log
+  storage.failReads = true;
+  DataLog dataLog(storage);
+  TEST_ASSERT_FALSE(dataLog.mount());
+
+  storage.failReads = false;
+  TEST_ASSERT_TRUE(dataLog.mount());
+  TEST_ASSERT_EQUAL_UINT32((1000 + DATALOG_RECORDS_PER_BLOCK - 1) / DATALOG_RECORDS_PER_BLOCK, dataLog.getBlockCount());
+}
+
+void test_failing_storage_never_overruns_the_write_block()
+{
+  FailingLogStorage storage;
+  DataLog dataLog(storage);
+  dataLog.mount();
+
+  uint32_t results[3] = {0, 0, 0};
+  for (uint32_t i = 0; i < 2 * DATALOG_RECORDS_PER_BLOCK; i++)
+    results[dataLog.append(makeRecord(i))]++;
+  // The record that fills the block is stored even though its write fails
+  TEST_ASSERT_EQUAL_UINT32(DATALOG_RECORDS_PER_BLOCK - 1, results[LOG_APPENDED]);
+  TEST_ASSERT_EQUAL_UINT32(1, results[LOG_WRITE_FAILED]);
+  TEST_ASSERT_EQUAL_UINT32(DATALOG_RECORDS_PER_BLOCK, results[LOG_DROPPED]);
+  TEST_ASSERT_EQUAL_UINT8(DATALOG_RECORDS_PER_BLOCK, dataLog.getPendingCount());
+  TEST_ASSERT_EQUAL_UINT32(DATALOG_RECORDS_PER_BLOCK, dataLog.getDroppedRecords());
+  TEST_ASSERT_FALSE(dataLog.sync(0));
+
+  // The buffered records stay readable while writes fail
+  uint32_t count = 0;
+  TEST_ASSERT_EQUAL_UINT32(DATALOG_RECORDS_PER_BLOCK, dataLog.query(0, UINT32_MAX, countRecord, &count));
+
+  // The full block is written by the next sync once storage recovers
+  storage.failing = false;
+  TEST_ASSERT_TRUE(dataLog.sync(0));
+  TEST_ASSERT_EQUAL_UINT32(1, dataLog.getBlockCount());
+  TEST_ASSERT_EQUAL_UINT8(0, dataLog.getPendingCount());
+  TEST_ASSERT_EQUAL(LOG_APPENDED, dataLog.append(makeRecord(2 * DATALOG_RECORDS_PER_BLOCK)));
+  TEST_ASSERT_EQUAL_UINT8(1, dataLog.getPendingCount());
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_remount_finds_every_block);
+  RUN_TEST(test_range_queries_seek_through_the_index);
+  RUN_TEST(test_visitor_can_end_a_query_early);
+  RUN_TEST(test_torn_last_block_is_dropped);
+  RUN_TEST(test_damage_beyond_the_last_block_does_not_mount);
+  RUN_TEST(test_unreadable_storage_does_not_mount);
+  RUN_TEST(test_failing_storage_never_overruns_the_write_block);
+  return UNITY_END();
+}
@@ -0,0 +1,189 @@
+// Telemetry export against a loopback collector socket: pio test -e native
+#include <math.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "TelemetryExporter.h"
+
+#define FLEET_SIZE 100 // Enough zones to span several datagrams
+
+// Stands in for WiFiUdpSink on the host
+class PosixUdpSink : public DatagramSink
+{
+private:
+  int socketFd;
+  sockaddr_in destination;
+
+public:
+  PosixUdpSink(const char *host, uint16_t port)
+  {
+    socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&destination, 0, sizeof(destination));
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(port);
+    inet_pton(AF_INET, host, &destination.sin_addr);
+  }
+
+  ~PosixUdpSink() { close(socketFd); }
+
+  bool send(const uint8_t *data, size_t length)
+  {
+    return sendto(socketFd, data, length, 0, (const sockaddr *)&destination, sizeof(destination)) == (ssize_t)length;
+  }
+};
+
+uint8_t addresses[FLEET_SIZE];
+DeviceStatusFrame frames[FLEET_SIZE];
+bool valid[FLEET_SIZE];
+
+// Deterministic fake sweep so the receiving side can check every field
+void fillFleet()
+{
+  for (size_t i = 0; i < FLEET_SIZE; i++)
+  {
+    addresses[i] = 0x08 + i;
+    valid[i] = i % 7 != 3;
+    if (!valid[i])
+    {
+      // What a short read leaves behind: padding that must not be exported
+      memset(&frames[i], 0xFF, sizeof(frames[i]));
+      continue;
+    }
+
+    frames[i].status = 1 + i % 2;
+    frames[i].moisture = (i * 37) % 1024;
+    frames[i].valveOpen = i % 2;
+    frames[i].uptimeSeconds = 1000 + i;
+    frames[i].flowPulses = 100000 * i;
+    frames[i].lastCommandResult = i % 4;
+    frames[i].errorCount = i;
+    sealFrame(frames[i]);
+  }
+}
+
+int openCollector(uint16_t &port)
+{
+  int collector = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addressLength = sizeof(address);
+  if (bind(collector, (sockaddr *)&address, sizeof(address)) != 0 ||
+      getsockname(collector, (sockaddr *)&address, &addressLength) != 0)
+  {
+    close(collector);
+    return -1;
+  }
+
+  timeval timeout = {1, 0};
+  setsockopt(collector, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  port = ntohs(address.sin_port);
+  return collector;
+}
+
+void setUp()
+{
+  fillFleet();
+}
+
+void tearDown()
+{
+}
+
+void test_fleet_round_trips_through_collector()
+{
+  uint16_t port;
+  int collector = openCollector(port);
+  TEST_ASSERT_TRUE_MESSAGE(collector >= 0, "collector socket");
+
+  PosixUdpSink sink("127.0.0.1", port);
+  TelemetryExporter exporter(sink);
+  exporter.setup(0xBEEF);
+  uint8_t sent = exporter.exportReadings(1700000000, 21.5, 48.25, addresses, frames, valid, FLEET_SIZE);
+  TEST_ASSERT_EQUAL_UINT8((FLEET_SIZE + TELEMETRY_MAX_RECORDS - 1) / TELEMETRY_MAX_RECORDS, sent);
+
+  size_t zones = 0;
+  uint8_t datagram[TELEMETRY_MAX_PACKET];
+  TelemetryRecord records[TELEMETRY_MAX_RECORDS];
+  for (uint8_t d = 0; d < sent; d++)
+  {
+    ssize_t length = recv(collector, datagram, sizeof(datagram), 0);
+    TelemetryHeader header;
+    int count = length > 0 ? decodeTelemetry(datagram, length, header, records, TELEMETRY_MAX_RECORDS) : -1;
+    TEST_ASSERT_TRUE_MESSAGE(count >= 0, "datagram missing or malformed");
+
+    TEST_ASSERT_EQUAL_UINT32(d, header.sequence);
+    TEST_ASSERT_EQUAL_UINT16(0xBEEF, header.controllerId);
+    TEST_ASSERT_EQUAL_UINT32(1700000000, header.timestamp);
+    TEST_ASSERT_EQUAL_INT16(2150, header.temperature);
+    TEST_ASSERT_EQUAL_UINT16(4825, header.humidity);
+
+    for (int i = 0; i < count; i++, zones++)
+    {
+      const TelemetryRecord &r = records[i];
+      const DeviceStatusFrame &f = frames[zones];
+      TEST_ASSERT_EQUAL_UINT8(addresses[zones], r.address);
+      if (valid[zones])
+      {
+        TEST_ASSERT_EQUAL_UINT8(TELEMETRY_FLAG_VALID | (f.valveOpen ? TELEMETRY_FLAG_VALVE_OPEN : 0), r.flags);
+        TEST_ASSERT_EQUAL_UINT8(f.status, r.status);
+        TEST_ASSERT_EQUAL_UINT16(f.moisture, r.moisture);
+        TEST_ASSERT_EQUAL_UINT32(f.flowPulses, r.flowPulses);
+        TEST_ASSERT_EQUAL_UINT32(f.uptimeSeconds, r.uptimeSeconds);
+        TEST_ASSERT_EQUAL_UINT16(f.errorCount, r.errorCount);
+      }
+      else
+      {
+        // Padding from the failed read must not reach collectors
+        TEST_ASSERT_EQUAL_UINT8(0, r.flags);
+        TEST_ASSERT_EQUAL_UINT8(0, r.status);
+        TEST_ASSERT_EQUAL_UINT8(0, r.lastCommandResult);
+        TEST_ASSERT_EQUAL_UINT16(0, r.moisture);
+        TEST_ASSERT_EQUAL_UINT32(0, r.flowPulses);
+        TEST_ASSERT_EQUAL_UINT32(0, r.uptimeSeconds);
+        TEST_ASSERT_EQUAL_UINT16(0, r.errorCount);
+      }
+    }
+  }
+  close(collector);
+
+  TEST_ASSERT_EQUAL(FLEET_SIZE, zones);
+  TEST_ASSERT_EQUAL_UINT32(0, exporter.getDroppedPackets());
+}
+
+void test_empty_fleet_still_sends_heartbeat()
+{
+  uint16_t port;
+  int collector = openCollector(port);
+  TEST_ASSERT_TRUE_MESSAGE(collector >= 0, "collector socket");
+
+  PosixUdpSink sink("127.0.0.1", port);
+  TelemetryExporter exporter(sink);
+  exporter.setup(0xBEEF);
+  TEST_ASSERT_EQUAL_UINT8(1, exporter.exportReadings(1700000000, NAN, NAN, addresses, frames, valid, 0));
+
+  uint8_t datagram[TELEMETRY_MAX_PACKET];
+  TelemetryHeader header;
+  TelemetryRecord records[TELEMETRY_MAX_RECORDS];
+  ssize_t length = recv(collector, datagram, sizeof(datagram), 0);
+  close(collector);
+  TEST_ASSERT_EQUAL(0, length > 0 ? decodeTelemetry(datagram, length, header, records, TELEMETRY_MAX_RECORDS) : -1);
+  TEST_ASSERT_EQUAL_INT16(TELEMETRY_UNKNOWN_TEMPERATURE, header.temperature);
+  TEST_ASSERT_EQUAL_UINT16(TELEMETRY_UNKNOWN_HUMIDITY, header.humidity);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_fleet_round_trips_through_collector);
+  RUN_TEST(test_empty_fleet_still_sends_heartbeat);
+  return UNITY_END();
+}
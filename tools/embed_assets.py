@@ -0,0 +1,147 @@
+"""Embeds the web/ dashboard into the parent firmware as gzip PROGMEM arrays.
+
+Runs as a PlatformIO pre-build script (extra_scripts = pre:tools/embed_assets.py)
+or standalone with `python3 tools/embed_assets.py`.
+
+Every asset is gzipped with a fixed mtime so the output and ETags are
+reproducible. Placeholders of the form {{name}} in HTML files are replaced by
+"name?v=<etag>", which lets the referenced assets be cached as immutable
+while the HTML itself is revalidated with its ETag.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+IMMUTABLE = "public, max-age=31536000, immutable"
+REVALIDATE = "no-cache"
+
+PLACEHOLDER = re.compile(r"\{\{([^}]+)\}\}")
+
+
+def compress(data):
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def etag(data):
+    return hashlib.sha1(data).hexdigest()[:16]
+
+
+def symbol(name):
+    return "asset_" + re.sub(r"[^0-9A-Za-z]", "_", name)
+
+
+def load_assets(web_dir):
+    names = sorted(
+        name
+        for name in os.listdir(web_dir)
+        if os.path.splitext(name)[1] in CONTENT_TYPES
+    )
+
+    assets = {}
+    # Non-HTML first so HTML placeholders can reference their ETags
+    for name in sorted(names, key=lambda n: n.endswith(".html")):
+        with open(os.path.join(web_dir, name), "rb") as f:
+            data = f.read()
+
+        extension = os.path.splitext(name)[1]
+        if extension == ".html":
+            def versioned(match):
+                target = match.group(1)
+                if target not in assets:
+                    raise SystemExit("%s references unknown asset %s" % (name, target))
+                return "%s?v=%s" % (target, assets[target]["etag"])
+
+            data = PLACEHOLDER.sub(versioned, data.decode("utf-8")).encode("utf-8")
+            cache = REVALIDATE
+        else:
+            cache = IMMUTABLE
+
+        body = compress(data)
+        assets[name] = {
+            "name": name,
+            "type": CONTENT_TYPES[extension],
+            "cache": cache,
+            "etag": etag(body),
+            "body": body,
+            "raw": len(data),
+        }
+
+    return [assets[name] for name in names]
+
+
+def render(assets):
+    lines = [
+        "// Generated by tools/embed_assets.py from web/. Do not edit.",
+        "#include <Arduino.h>",
+        '#include "WebAssets.h"',
+        "",
+    ]
+
+    for asset in assets:
+        lines.append("// %s: %d bytes, %d gzipped" % (asset["name"], asset["raw"], len(asset["body"])))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % symbol(asset["name"]))
+        body = asset["body"]
+        for i in range(0, len(body), 16):
+            lines.append("  " + ", ".join("0x%02x" % b for b in body[i : i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("const WebAsset webAssets[] = {")
+    for asset in assets:
+        lines.append(
+            '  {"/%s", "%s", "\\"%s\\"", "%s", %s, sizeof(%s)},'
+            % (
+                asset["name"],
+                asset["type"],
+                asset["etag"],
+                asset["cache"],
+                symbol(asset["name"]),
+                symbol(asset["name"]),
+            )
+        )
+    lines.append("};")
+    lines.append("")
+    lines.append("const size_t webAssetCount = sizeof(webAssets) / sizeof(webAssets[0]);")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    output = os.path.join(project_dir, "lib", "Web", "src", "WebAssetData.cpp")
+
+    assets = load_assets(web_dir)
+    source = render(assets)
+
+    # Leave the file untouched when nothing changed to avoid needless rebuilds
+    if os.path.exists(output):
+        with open(output) as f:
+            if f.read() == source:
+                return
+
+    with open(output, "w") as f:
+        f.write(source)
+
+    for asset in assets:
+        print(
+            "Embedded %s: %d -> %d bytes (etag %s)"
+            % (asset["name"], asset["raw"], len(asset["body"]), asset["etag"])
+        )
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,216 @@
+"""Reports static RAM (.data + .bss) per module from the linker map.
+
+Runs as a PlatformIO post-link script (extra_scripts = post:tools/ram_report.py)
+or standalone with `python3 tools/ram_report.py <firmware.map> [budget]`;
+`python3 tools/ram_report.py --selftest` checks the parser against a fixture map.
+
+Only input sections that survived --gc-sections are counted, so the numbers
+match what is actually in the image. Sizes are grouped by module: a file in
+src/, a project or registry library, the Arduino core, or a toolchain archive.
+The previous report is kept next to the map so every build prints the change
+per module, and the build fails when the total exceeds custom_static_ram_budget.
+"""
+
+import json
+import os
+import re
+import sys
+
+RAM_SECTIONS = (".data", ".bss", ".noinit", ".relocate")
+
+# .data is copied from flash at startup, so ld appends "load address 0x..." to it
+OUTPUT_SECTION = re.compile(
+    r"^(\.[\w.]+)(?:\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+(?:\s+load address\s+0x[0-9a-fA-F]+)?)?\s*$"
+)
+INPUT_NAME = re.compile(r"^ (\S+)\s*$")
+INPUT_SECTION = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+ARCHIVE_MEMBER = re.compile(r"^(.*?)([^/\\]+)\.a\((.+)\)$")
+
+
+def module_name(path, build_dir):
+    # The linker runs from the project directory and prints build paths relative to it
+    if build_dir:
+        path = os.path.abspath(path)
+    path = path.replace("\\", "/")
+    member = ARCHIVE_MEMBER.match(path)
+    if member:
+        directory, archive, obj = member.groups()
+        if archive == "libFrameworkArduino":
+            return "framework/" + re.sub(r"\.o$", "", obj)
+        if build_dir and directory.startswith(build_dir):
+            return "lib/" + re.sub(r"^lib", "", archive)
+        return "toolchain/" + archive + ".a"
+
+    if build_dir and path.startswith(build_dir):
+        parts = path[len(build_dir):].strip("/").split("/")
+        if parts[0] == "src":
+            return re.sub(r"\.o$", "", "/".join(parts))
+        if parts[0] == "FrameworkArduino":
+            return "framework/" + re.sub(r"\.o$", "", parts[-1])
+        if len(parts) > 2:
+            return "lib/" + parts[1]
+
+    return os.path.basename(path)
+
+
+def parse_lines(lines, build_dir=None):
+    if build_dir:
+        build_dir = build_dir.replace("\\", "/").rstrip("/") + "/"
+
+    modules = {}
+    in_memory_map = False
+    in_ram = False
+    pending = None
+
+    for line in lines:
+        line = line.rstrip()
+        if not in_memory_map:
+            in_memory_map = line.startswith("Linker script and memory map")
+            continue
+
+        output = OUTPUT_SECTION.match(line)
+        if output:
+            in_ram = output.group(1) in RAM_SECTIONS
+            pending = None
+            continue
+        if not in_ram:
+            continue
+
+        # Long section names put address, size and file on the next line
+        name = INPUT_NAME.match(line)
+        if name and not line.startswith(" *"):
+            pending = name.group(1)
+            continue
+
+        section = INPUT_SECTION.match(line)
+        if section and (section.group(1) or pending):
+            size = int(section.group(3), 16)
+            if size > 0:
+                if (section.group(1) or pending) == "*fill*":
+                    module = "(alignment)"
+                else:
+                    module = module_name((section.group(4) or "").strip(), build_dir)
+                modules[module] = modules.get(module, 0) + size
+        pending = None
+
+    return modules
+
+
+def parse_map(map_path, build_dir=None):
+    with open(map_path) as f:
+        return parse_lines(f, build_dir)
+
+
+# Trimmed from an avr-gcc map of the child: .data 0x1c and .bss 0x40, 92 bytes in all
+FIXTURE_MAP = """\
+Memory Configuration
+
+Name             Origin             Length             Attributes
+data             0x0000000000800060 0x000000000000ffa0 rw !x
+
+Linker script and memory map
+
+.text           0x0000000000000000      0xa4e
+ .text          0x0000000000000000       0x10 .pio/build/childNode/src/main-child.cpp.o
+
+.data           0x0000000000800100       0x1c load address 0x0000000000000a4e
+                0x0000000000800100                PROVIDE (__data_start = .)
+ *(.data)
+ .data          0x0000000000800100        0x0 /toolchain-atmelavr/avr/lib/avr5/crtatmega328p.o
+ *(.data*)
+ .data.nextAvailableAddress
+                0x0000000000800100        0x1 .pio/build/childNode/src/main-child.cpp.o
+ *(.rodata)
+ .rodata.str1.1
+                0x0000000000800101       0x1a .pio/build/childNode/src/main-child.cpp.o
+ *fill*         0x000000000080011b        0x1 
+                0x000000000080011c                _edata = .
+
+.bss            0x000000000080011c       0x40
+                0x000000000080011c                PROVIDE (__bss_start = .)
+ *(.bss*)
+ .bss.memoryFrame
+                0x000000000080011c        0xf .pio/build/childNode/src/main-child.cpp.o
+ *(COMMON)
+ COMMON         0x000000000080012b       0x31 .pio/build/childNode/libFrameworkArduino.a(HardwareSerial0.cpp.o)
+                0x000000000080015c                PROVIDE (__bss_end = .)
+
+.comment        0x0000000000000000       0x11
+"""
+
+FIXTURE_MODULES = {
+    "src/main-child.cpp": 0x1 + 0x1a + 0xf,
+    "(alignment)": 0x1,
+    "framework/HardwareSerial0.cpp": 0x31,
+}
+
+
+def selftest():
+    build_dir = os.path.abspath(os.path.join(".pio", "build", "childNode"))
+    modules = parse_lines(FIXTURE_MAP.splitlines(), build_dir)
+    ok = modules == FIXTURE_MODULES and sum(modules.values()) == 0x1c + 0x40
+    print(render(modules, {}, 0))
+    print("PASS" if ok else "FAIL expected %r" % FIXTURE_MODULES)
+    return ok
+
+
+def render(modules, previous, budget):
+    lines = ["Static RAM by module (.data + .bss)"]
+    width = max([len(m) for m in list(modules) + list(previous)] + [6])
+    for module, size in sorted(modules.items(), key=lambda item: (-item[1], item[0])):
+        delta = size - previous.get(module, 0) if previous else 0
+        change = " (%+d)" % delta if delta else ""
+        lines.append("  %-*s %6d%s" % (width, module, size, change))
+    for module in sorted(set(previous) - set(modules)):
+        lines.append("  %-*s %6d (%+d)" % (width, module, 0, -previous[module]))
+
+    total = sum(modules.values())
+    previous_total = sum(previous.values()) if previous else total
+    change = " (%+d)" % (total - previous_total) if total != previous_total else ""
+    if budget:
+        lines.append("  %-*s %6d%s of %d budget" % (width, "total", total, change, budget))
+    else:
+        lines.append("  %-*s %6d%s" % (width, "total", total, change))
+    return "\n".join(lines)
+
+
+def report(map_path, build_dir=None, budget=0):
+    """Prints the report and returns False when the budget is exceeded."""
+    history = os.path.join(os.path.dirname(map_path), "ram_report.json")
+    previous = {}
+    if os.path.exists(history):
+        with open(history) as f:
+            previous = json.load(f)
+
+    modules = parse_map(map_path, build_dir)
+    print(render(modules, previous, budget))
+
+    with open(history, "w") as f:
+        json.dump(modules, f, indent=1, sort_keys=True)
+
+    total = sum(modules.values())
+    if budget and total > budget:
+        print("Error: static RAM %d exceeds custom_static_ram_budget %d" % (total, budget))
+        return False
+    return True
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+
+    map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")  # noqa: F821
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])  # noqa: F821
+    budget = int(env.GetProjectOption("custom_static_ram_budget", "0"))  # noqa: F821
+
+    def post_link(target, source, env):
+        return 0 if report(map_path, env.subst("$BUILD_DIR"), budget) else 1
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", post_link)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        if len(sys.argv) > 1 and sys.argv[1] == "--selftest":
+            sys.exit(0 if selftest() else 1)
+        if len(sys.argv) < 2:
+            sys.exit("usage: ram_report.py <firmware.map> [budget]")
+        ok = report(sys.argv[1], budget=int(sys.argv[2]) if len(sys.argv) > 2 else 0)
+        sys.exit(0 if ok else 1)
@@ -0,0 +1,183 @@
+"""Collects binary telemetry datagrams from one or more parent controllers.
+
+Listens on UDP (the parent broadcasts to port 4210 by default), decodes each
+datagram and prints one line per zone, either as text or CSV. Sequence gaps
+are reported per controller so packet loss is visible.
+
+    python3 tools/telemetry_collector.py                  # listen on 0.0.0.0:4210
+    python3 tools/telemetry_collector.py --csv > log.csv
+    python3 tools/telemetry_collector.py --bind 127.0.0.1 --count 4
+
+The wire format is documented in lib/Telemetry/src/TelemetryPacket.h.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+from datetime import datetime, timezone
+
+MAGIC = 0x5449
+VERSION = 1
+HEADER = struct.Struct("<HBBHIIhH")
+RECORD = struct.Struct("<BBBBHHII")
+UNKNOWN_TEMPERATURE = -32768
+UNKNOWN_HUMIDITY = 0xFFFF
+
+FLAG_VALID = 0x01
+FLAG_VALVE_OPEN = 0x02
+
+STATUS = {0: "uninitialized", 1: "active", 2: "standby"}
+RESULTS = {0: "none", 1: "ok", 2: "unknown", 3: "malformed"}
+
+CSV_FIELDS = [
+    "controller",
+    "sequence",
+    "timestamp",
+    "temperature",
+    "humidity",
+    "address",
+    "valid",
+    "status",
+    "moisture",
+    "valve_open",
+    "uptime",
+    "flow_pulses",
+    "last_command",
+    "errors",
+]
+
+
+class DecodeError(Exception):
+    pass
+
+
+def decode(datagram):
+    """Returns (header dict, list of record dicts) for one datagram."""
+    if len(datagram) < HEADER.size:
+        raise DecodeError("short datagram (%d bytes)" % len(datagram))
+
+    magic, version, count, controller, sequence, timestamp, temperature, humidity = HEADER.unpack_from(datagram)
+    if magic != MAGIC or version != VERSION:
+        raise DecodeError("bad magic/version %04x/%d" % (magic, version))
+    if len(datagram) != HEADER.size + count * RECORD.size:
+        raise DecodeError("length %d does not match %d records" % (len(datagram), count))
+
+    header = {
+        "controller": controller,
+        "sequence": sequence,
+        "timestamp": timestamp,
+        "temperature": None if temperature == UNKNOWN_TEMPERATURE else temperature / 100.0,
+        "humidity": None if humidity == UNKNOWN_HUMIDITY else humidity / 100.0,
+    }
+
+    records = []
+    for i in range(count):
+        address, flags, status, result, moisture, errors, uptime, pulses = RECORD.unpack_from(
+            datagram, HEADER.size + i * RECORD.size
+        )
+        records.append(
+            {
+                "address": address,
+                "valid": bool(flags & FLAG_VALID),
+                "status": STATUS.get(status, status),
+                "moisture": moisture,
+                "valve_open": bool(flags & FLAG_VALVE_OPEN),
+                "uptime": uptime,
+                "flow_pulses": pulses,
+                "last_command": RESULTS.get(result, result),
+                "errors": errors,
+            }
+        )
+
+    return header, records
+
+
+class SequenceTracker:
+    """Counts datagrams lost between consecutive sequence numbers per controller."""
+
+    def __init__(self):
+        self.last = {}
+        self.lost = {}
+
+    def update(self, controller, sequence):
+        previous = self.last.get(controller)
+        self.last[controller] = sequence
+        if previous is None or sequence <= previous:
+            # First datagram, or the controller rebooted and restarted at 0
+            return 0
+        gap = sequence - previous - 1
+        self.lost[controller] = self.lost.get(controller, 0) + gap
+        return gap
+
+
+def format_text(header, record):
+    when = datetime.fromtimestamp(header["timestamp"], timezone.utc).strftime("%Y-%m-%d %H:%M:%S")
+    if not record["valid"]:
+        state = "no response"
+    else:
+        state = "moisture %4d  valve %-6s  flow %8d  uptime %8ds  last %-9s  errors %d" % (
+            record["moisture"],
+            "open" if record["valve_open"] else "closed",
+            record["flow_pulses"],
+            record["uptime"],
+            record["last_command"],
+            record["errors"],
+        )
+    return "%s  %04x#%-6d 0x%02x  %s" % (when, header["controller"], header["sequence"], record["address"], state)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bind", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--port", type=int, default=4210, help="UDP port to listen on")
+    parser.add_argument("--csv", action="store_true", help="print CSV instead of text")
+    parser.add_argument("--count", type=int, default=0, help="exit after this many datagrams")
+    parser.add_argument("--timeout", type=float, default=None, help="exit if nothing arrives for this many seconds")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((args.bind, args.port))
+    sock.settimeout(args.timeout)
+
+    if args.csv:
+        print(",".join(CSV_FIELDS))
+
+    tracker = SequenceTracker()
+    received = 0
+    try:
+        while args.count == 0 or received < args.count:
+            try:
+                datagram, sender = sock.recvfrom(2048)
+            except socket.timeout:
+                break
+
+            try:
+                header, records = decode(datagram)
+            except DecodeError as error:
+                print("%s: %s" % (sender[0], error), file=sys.stderr)
+                continue
+
+            received += 1
+            gap = tracker.update(header["controller"], header["sequence"])
+            if gap:
+                print("controller %04x: %d datagram(s) lost" % (header["controller"], gap), file=sys.stderr)
+
+            for record in records:
+                if args.csv:
+                    row = dict(header, **record)
+                    print(",".join("" if row[f] is None else str(row[f]) for f in CSV_FIELDS))
+                else:
+                    print(format_text(header, record))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+    lost = sum(tracker.lost.values())
+    print("%d datagram(s) received, %d lost" % (received, lost), file=sys.stderr)
+    return 0 if lost == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
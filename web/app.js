@@ -0,0 +1,89 @@
+// Dashboard: renders /api/status once, then patches values from /events.
+
+var COMMANDS = ['START', 'STOP', 'IDENTIFY', 'SLEEP'];
+var RESULTS = ['-', 'ok', 'unknown', 'malformed'];
+
+function hex(address) {
+  return (address < 16 ? '0' : '') + address.toString(16);
+}
+
+// Temperature and humidity are null while the DHT sensor fails to read
+function fixed(value) {
+  return value === null ? '-' : value.toFixed(2);
+}
+
+function set(id, value) {
+  var element = document.getElementById(id);
+  if (element) element.textContent = value;
+}
+
+function cell(row, id, value) {
+  var td = row.insertCell();
+  if (id) td.id = id;
+  td.textContent = value;
+  return td;
+}
+
+function sendCommand(command, address) {
+  fetch('/' + command + '?address=' + hex(address)).then(refresh);
+}
+
+function render(status) {
+  set('temperature', fixed(status.temperature));
+  set('humidity', fixed(status.humidity));
+
+  var body = document.getElementById('devices');
+  body.textContent = '';
+  document.getElementById('empty').hidden = status.devices.length > 0;
+
+  status.devices.forEach(function (device) {
+    var row = body.insertRow();
+    cell(row, null, '0x' + hex(device.address));
+    if (device.valid) {
+      cell(row, 'moisture-' + device.address, device.moisture);
+      cell(row, 'valve-' + device.address, device.valveOpen ? 'open' : 'closed');
+      cell(row, null, device.uptime + ' s');
+      cell(row, null, device.flowPulses);
+      cell(row, null, RESULTS[device.lastCommand] || device.lastCommand);
+      cell(row, null, device.errors);
+    } else {
+      cell(row, null, 'no response').className = 'offline';
+      for (var i = 0; i < 5; i++) cell(row, null, '');
+    }
+
+    var actions = row.insertCell();
+    COMMANDS.forEach(function (command) {
+      var button = document.createElement('button');
+      button.textContent = command.charAt(0) + command.slice(1).toLowerCase();
+      button.onclick = function () {
+        sendCommand(command, device.address);
+      };
+      actions.appendChild(button);
+    });
+  });
+}
+
+function refresh() {
+  return fetch('/api/status')
+    .then(function (response) {
+      return response.json();
+    })
+    .then(render);
+}
+
+refresh();
+
+var events = new EventSource('/events');
+events.addEventListener('reading', function (e) {
+  var d = JSON.parse(e.data);
+  set('moisture-' + d.address, d.moisture);
+});
+events.addEventListener('valve', function (e) {
+  var d = JSON.parse(e.data);
+  set('valve-' + d.address, d.open ? 'open' : 'closed');
+});
+events.addEventListener('environment', function (e) {
+  var d = JSON.parse(e.data);
+  set('temperature', fixed(d.temperature));
+  set('humidity', fixed(d.humidity));
+});